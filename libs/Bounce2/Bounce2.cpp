@@ -149,6 +149,6 @@ void Bounce::attach(int pin, int mode){
 }
 
 unsigned long millis() {
-    return (unsigned long)(time_us_64() / 1000);
+    return hal::millis();
 }
 
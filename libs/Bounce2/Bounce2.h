@@ -29,8 +29,7 @@
 #pragma once
 
 #include <inttypes.h>
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
+#include "Hal.h"
 
 /**
      @brief  The Debouce class. Just the deboucing code separated from all harware.
@@ -230,12 +229,10 @@ protected:
 
 	uint8_t pin;
 
-	virtual bool readCurrentState() { return gpio_get(pin); }
+	virtual bool readCurrentState() { return hal::gpio_read(pin); }
 	virtual void setPinMode(int pin, int mode) {
-		gpio_init(pin);
-    gpio_set_dir(pin, GPIO_IN);
     //FIXME : switch for pulldown or not
-    gpio_pull_up(pin);
+    hal::gpio_input(pin, true);
 	}
 
 
@@ -0,0 +1,118 @@
+#pragma once
+
+#include <cstdint>
+
+#include "Hal.h"
+
+/// @brief Debounces up to 32 GPIOs at once from one snapshot per tick
+/// @details Each input has a 2-bit vertical counter: bit 0 of every counter
+/// lives in one word, bit 1 in another, so one tick is a few logic
+/// operations on 32-bit words, whatever the number of inputs. A counter
+/// runs while its input differs from the debounced state and resets when
+/// they agree; the state follows after 4 consecutive differing ticks,
+/// 16 ms at the 4 ms timer. Timestamps come from one millis() per tick and
+/// are only written for inputs which changed.
+/// Call update() once per tick, from one context, before anything reads
+/// the rose/fell masks of that tick.
+class DebounceBank {
+public:
+    static constexpr unsigned TICKS = 4;
+
+    constexpr DebounceBank() {}
+
+    /// @brief Configure pin as an input and start debouncing it
+    /// @details The debounced state starts at the current level, without
+    /// an edge.
+    void attach(unsigned pin, bool pull_up) {
+        const uint32_t bit = 1U << pin;
+        hal::gpio_input(pin, pull_up);
+        _mask |= bit;
+        _state = (_state & ~bit) | (hal::gpio_read_all() & bit);
+        _changed_ms[pin] = _now_ms;
+    }
+
+    /// @brief Sample every attached input, one tick
+    void update() { update(hal::gpio_read_all(), hal::millis()); }
+
+    /// @brief One tick from a snapshot taken elsewhere
+    /// @param levels GPIO levels, bit n is GPIOn
+    void update(uint32_t levels, uint32_t now_ms) {
+        _now_ms = now_ms;
+        const uint32_t delta = (levels ^ _state) & _mask;
+        // count up where the input differs, clear where it agrees
+        _count_1 = (_count_1 ^ _count_0) & delta;
+        _count_0 = ~_count_0 & delta;
+        // a counter wrapped back to 0 while still differing: TICKS passed
+        const uint32_t toggle = delta & ~(_count_0 | _count_1);
+        _state ^= toggle;
+        _rose = toggle & _state;
+        _fell = toggle & ~_state;
+        for (uint32_t changes = toggle; changes; changes &= changes - 1) {
+            const unsigned pin = (unsigned)__builtin_ctz(changes);
+            _previous_ms[pin] = now_ms - _changed_ms[pin];
+            _changed_ms[pin] = now_ms;
+        }
+    }
+
+    /// @brief Debounced levels, bit n is GPIOn
+    uint32_t state() const { return _state; }
+
+    /// @brief Inputs which went high or low on the last tick
+    uint32_t rose() const { return _rose; }
+    uint32_t fell() const { return _fell; }
+
+    /// @brief Time the input has been in its debounced state, at the last
+    /// tick
+    uint32_t currentDuration(unsigned pin) const {
+        return _now_ms - _changed_ms[pin];
+    }
+
+    /// @brief Time the input spent in its previous debounced state
+    uint32_t previousDuration(unsigned pin) const { return _previous_ms[pin]; }
+
+private:
+    uint32_t _mask = 0;
+    uint32_t _state = 0;
+    uint32_t _count_0 = 0;
+    uint32_t _count_1 = 0;
+    uint32_t _rose = 0;
+    uint32_t _fell = 0;
+    uint32_t _now_ms = 0;
+    uint32_t _changed_ms[32] = {};
+    uint32_t _previous_ms[32] = {};
+};
+
+/// @brief One DebounceBank input behind the Bounce2 interface, as the
+/// ButtonT of StaticEncoderButton
+/// @details Holds nothing but its pin: the bank is a template parameter.
+/// update() reports the bank's last tick, so it has to be called once per
+/// DebounceBank::update(). interval() is ignored, see DebounceBank::TICKS.
+/// @tparam Bank The bank, an object with static storage duration
+template <DebounceBank &Bank>
+class BankButton {
+public:
+    void attach(int pin, int mode) {
+        _pin = (uint8_t)pin;
+        // INPUT_PULLUP of Bounce2
+        Bank.attach(_pin, mode == 0x2);
+    }
+
+    void interval(uint16_t) {}
+
+    /// @return True if the pin changed state on the bank's last tick
+    bool update() const { return ((Bank.rose() | Bank.fell()) >> _pin) & 1U; }
+
+    bool read() const { return (Bank.state() >> _pin) & 1U; }
+    bool rose() const { return (Bank.rose() >> _pin) & 1U; }
+    bool fell() const { return (Bank.fell() >> _pin) & 1U; }
+
+    unsigned long currentDuration() const {
+        return Bank.currentDuration(_pin);
+    }
+    unsigned long previousDuration() const {
+        return Bank.previousDuration(_pin);
+    }
+
+private:
+    uint8_t _pin = 0;
+};
@@ -29,8 +29,10 @@
 #pragma once
 
 #include <inttypes.h>
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
+#include "Hal.h"
+#ifdef ENCODER_USE_PIO
+#include "EncoderPio.h"
+#endif
 
 #define ENCODER_ISR_ATTR
 
@@ -49,41 +51,65 @@ class Encoder
 {
 public:
 	Encoder(uint8_t pin1, uint8_t pin2) {
-		gpio_init(pin1);
-		gpio_set_dir(pin1, GPIO_IN);
-		gpio_pull_up(pin1);
-		gpio_init(pin2);
-		gpio_set_dir(pin2, GPIO_IN);
-		gpio_pull_up(pin2);
+		hal::gpio_input(pin1, true);
+		hal::gpio_input(pin2, true);
 		encoder.pin1 = pin1;
 		encoder.pin2 = pin2;
 		encoder.position = 0;
 		// allow time for a passive R-C filter to charge
 		// through the pullup resistors, before reading
 		// the initial state
-		sleep_us(2000);
+		hal::sleep_us(2000);
 		uint8_t s = 0;
-		if (gpio_get(encoder.pin1)) s |= 1;
-		if (gpio_get(encoder.pin2)) s |= 2;
+		if (hal::gpio_read(encoder.pin1)) s |= 1;
+		if (hal::gpio_read(encoder.pin2)) s |= 2;
 		encoder.state = s;
+#ifdef ENCODER_USE_PIO
+		// Counted in hardware when the pins are consecutive and a state
+		// machine is free, polled otherwise
+		pioActive = pin2 == pin1 + 1 && encoder_pio::start(pin1, &pio);
+		if (pioActive) pioBase = encoder_pio::count(pio);
+#endif
 	}
 
 	inline int32_t read() {
+#ifdef ENCODER_USE_PIO
+		if (pioActive) return encoder_pio::count(pio) - pioBase;
+#endif
 		update(&encoder);
 		return encoder.position;
 	}
 	inline int32_t readAndReset() {
+#ifdef ENCODER_USE_PIO
+		if (pioActive) {
+			const int32_t count = encoder_pio::count(pio);
+			const int32_t ret = count - pioBase;
+			pioBase = count;
+			return ret;
+		}
+#endif
 		update(&encoder);
 		int32_t ret = encoder.position;
 		encoder.position = 0;
 		return ret;
 	}
 	inline void write(int32_t p) {
+#ifdef ENCODER_USE_PIO
+		if (pioActive) {
+			pioBase = encoder_pio::count(pio) - p;
+			return;
+		}
+#endif
 		encoder.position = p;
 	}
 
 private:
 	Encoder_internal_state_t encoder;
+#ifdef ENCODER_USE_PIO
+	encoder_pio::Channel pio = {};
+	bool pioActive = false;
+	int32_t pioBase = 0;  // count at position 0
+#endif
 
 //                           _______         _______       
 //               Pin1 ______|       |_______|       |______ Pin1
@@ -115,8 +141,8 @@ public:
 	// but it is public to allow static interrupt routines.
 	// DO NOT call update() directly from sketches.
 	static void update(Encoder_internal_state_t *arg) {
-		uint8_t p1val = gpio_get(arg->pin1);
-		uint8_t p2val = gpio_get(arg->pin2);
+		uint8_t p1val = hal::gpio_read(arg->pin1);
+		uint8_t p2val = hal::gpio_read(arg->pin2);
 		uint8_t state = arg->state & 3;
 		if (p1val) state |= 4;
 		if (p2val) state |= 8;
@@ -0,0 +1,50 @@
+#include "EncoderPio.h"
+
+#include "hardware/gpio.h"
+#include "hardware/pio.h"
+#include "quadrature_encoder.pio.h"
+
+namespace encoder_pio {
+
+namespace {
+
+bool s_loaded[2] = {false, false};
+
+PIO instance(unsigned index) { return index ? pio1 : pio0; }
+
+}  // namespace
+
+bool start(unsigned pin, Channel *channel) {
+    for (unsigned index = 0; index < 2; ++index) {
+        PIO pio = instance(index);
+        // The jump table addresses are absolute, the program can only live
+        // at offset 0 and is shared by every encoder on the block
+        if (!s_loaded[index] &&
+            !pio_can_add_program_at_offset(pio, &quadrature_encoder_program,
+                                           0)) {
+            continue;
+        }
+        const int sm = pio_claim_unused_sm(pio, false);
+        if (sm < 0) continue;
+        if (!s_loaded[index]) {
+            pio_add_program_at_offset(pio, &quadrature_encoder_program, 0);
+            s_loaded[index] = true;
+        }
+        quadrature_encoder_program_init(pio, (uint)sm, pin);
+        channel->pio = (uint8_t)index;
+        channel->sm = (uint8_t)sm;
+        return true;
+    }
+    return false;
+}
+
+int32_t count(const Channel &channel) {
+    PIO pio = instance(channel.pio);
+    // Pushes are non-blocking, so a full FIFO holds the oldest counts
+    unsigned entries = pio_sm_get_rx_fifo_level(pio, channel.sm) + 1U;
+    uint32_t value = 0;
+    while (entries--) value = pio_sm_get_blocking(pio, channel.sm);
+    return (int32_t)value;
+}
+
+}  // namespace encoder_pio
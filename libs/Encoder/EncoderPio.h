@@ -0,0 +1,26 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Quadrature decoding in a PIO state machine, see
+/// quadrature_encoder.pio. Pico only, enabled by ENCODER_USE_PIO.
+namespace encoder_pio {
+
+/// @brief State machine which counts one encoder
+struct Channel {
+    uint8_t pio;
+    uint8_t sm;
+};
+
+/// @brief Load the decoder, once per PIO block, and start a state machine
+/// on pin and pin + 1
+/// @return False if no PIO block has a free state machine and offset 0
+/// free or holding the decoder already
+bool start(unsigned pin, Channel *channel);
+
+/// @brief Edges counted since start(), wrapping at 32 bits
+/// @details Takes the newest count from the RX FIFO: the stale ones are
+/// drained and the state machine pushes a fresh one within 10 PIO cycles.
+int32_t count(const Channel &channel);
+
+}  // namespace encoder_pio
@@ -33,20 +33,15 @@
 #ifndef EncoderButton_h
 #define EncoderButton_h
 
-#include <Encoder.h>
-#include <Bounce2.h>
 #include <functional>
+#include "EncoderButtonCore.h"
 
-#define HIGH 0x1
-#define LOW  0x0
-
-#define INPUT 0x0
-#define OUTPUT 0x1
-#define INPUT_PULLUP 0x2
-
-typedef uint8_t byte;
-
-class EncoderButton {
+/**
+ * Encoder and button on the heap, std::function handlers. The events and
+ * their timing come from EncoderButtonCore, see there for the setup,
+ * state and event queue functions.
+ */
+class EncoderButton : public EncoderButtonCore<EncoderButton> {
 
   protected:
 
@@ -68,13 +63,6 @@ class EncoderButton {
      */
     EncoderButton(byte switchPin);
 
-
-    /**
-     * Read the position of the encoder and update the state of the button.
-     * Call from loop() for each defined EncoderButton
-     */
-    void update();
-    
     /** ***************************************************
      * set button callback handlers
      */
@@ -160,74 +148,8 @@ class EncoderButton {
      * Fired after the encoder or button has been idle for 
      * setIdleTimeout(ms) (default 10 seconds)
      */
-    void setIdleHandler(CallbackFunction f);    
-
-    
-    /** ***************************************
-     *  button setup
-     */
-
-    /**
-     * Default is set in the Bounce2 library (currently 10ms)
-     */
-    void setDebounceInterval(unsigned int intervalMs);
-
-    /**
-     * Set the interval in ms between double, triple or
-     * multi clicks
-     */
-    void setMultiClickInterval(unsigned int intervalMs);
+    void setIdleHandler(CallbackFunction f);
 
-    /**
-     * Set the ms that defines a lonf click. Long pressed callback
-     * will be fired at this interval if repeat is set to true via the
-     * setLongPressHandler()
-     */
-    void setLongClickDuration(unsigned int longDurationMs);
-
-    /**
-     * Choose whether to repeat the long press callback
-     * (default is 'false')
-     */
-    void setLongPressRepeat(bool repeat=false);
-    
-    /** ***************************************
-     *  encoder setup
-     */
-
-    /**
-     * Encoder callbacks are normally fired on every loop() but for MPG
-     * style encoders this can fire a huge number of events (that may 
-     * swamp a serial connection).
-     * The encoder interupts will sitll be called but this will limit 
-     * the call back firing to every set ms - read the 
-     * EncoderButton.increment() for lossless counting of encoder.
-     * Set to zero (default) for no rate limit.
-     */
-    void setRateLimit(long ms);
-
-    /**
-     * Quadrature encoders have four states for each 'click' of the 
-     * rotary switch. By default we only fire once per click.
-     * Set this to 'true' if you want four events per click.
-     * Affects pressed+turning too.
-     */
-    void useQuadPrecision(bool prec);
-
-    /**
-     * Reset the counted position of the encoder. 
-     */
-    void resetPosition(long pos = 0);
-    
-    /**
-     * Reset the counted pressed position of the encoder. 
-     */
-    void resetPressedPosition(long pos = 0);    
-
-    /**
-     * Set the idle timeout in ms (default 10000) 
-     */
-    void setIdleTimeout(unsigned int timeoutMs);
 
     /**
      * Set the button identifier (not unique, defaults to 0)
@@ -242,72 +164,6 @@ class EncoderButton {
      */
     void setUserState(unsigned int s);
 
-    
-    /** ***************************************
-     *  button state
-     */
-     
-    /**
-     * Directly get the current button state from Bounce2
-     */
-    bool buttonState();
-
-    /**
-     * Directly get the duration of the button current state from Bounce2
-     */
-    unsigned long currentDuration();
-
-    /**
-     * Directly get the duration of the button previous state from Bounce2
-     */
-    unsigned long previousDuration();
-
-    /**
-     * The number of multi-clicks that have been fired in the clicked event
-     */
-    unsigned char clickCount();
-
-    
-    /**
-     * The number of times the long press handler has  been fired in the 
-     * button pressed event
-     */
-    uint8_t longPressCount();
-    
-    /**
-     * Returns true if pressed
-     */
-    bool isPressed();
-
-
-    /** ***************************************
-     *  encoder state
-     */
-
-    /**
-     * Returns a positive (CW) or negative (CCW) integer. Is normally 1 or -1 but if your 
-     * loop() has lots of processing, your Arduino is slow or you setRateLimit()
-     * this will report the actual number of increments made by the encoder since
-     * the last encoder handler event.
-     */
-    int16_t increment();
-
-    /**
-     * The current position of the encoder. Can be reset by resetPosition()
-     */
-    long position();
-
-    /**
-     * The current position of the encoder when pressed. Can be reset by resetPressedPosition()
-     */
-    long pressedPosition();
-    
-
-    /** ***************************************
-     * Returns the number of ms since any event was fired for this encoder/button
-     */
-    unsigned long msSinceLastEvent();
-
     /**
      * Get the button identifier (not unique, defaults to 0)
      */
@@ -318,18 +174,6 @@ class EncoderButton {
      */
     unsigned int userState();
 
-    /**
-     * Returns true if enabled
-     */
-    bool enabled();
-
-    /**
-     * Set enabled to true of false
-     * This will enable/disable all event callbacks.
-     * When disabled the encoder positions will not be updated.
-     */
-    void enable(bool e=true);
-
   protected:
     
     CallbackFunction changed_cb = NULL;
@@ -349,40 +193,23 @@ class EncoderButton {
 
 
   private:
-    Encoder* encoder;
-    Bounce* bounce;
+    friend class EncoderButtonCore<EncoderButton>;
+
+    Encoder* encoder = NULL;
+    Bounce* bounce = NULL;
     bool haveButton = false;
     bool haveEncoder = false;
-    uint8_t positionDivider = 4;
-    int32_t encoderPosition  = 0;
-    int32_t currentPosition  = 0;
-    int32_t currentPressedPosition  = 0;
-    int encoderIncrement  = 0;
-    bool encodingPressed = false;
-    unsigned char _buttonState = HIGH;
-    unsigned int multiClickInterval = 250;
-    unsigned int longClickDuration = 750;
-    bool clickFired = true;
-    unsigned char clickCounter = 0;
-    unsigned int longPressCounter = 0;
-    unsigned long lastEventMs = millis();
-    unsigned long idleTimeout = 10000;
-    bool idleFlagged = false;
-    bool previousState = LOW;
-    unsigned char prevClickCount = 0;
-    bool repeatLongPress = false;
-
-    unsigned int rateLimit = 0;
-    unsigned long rateLimitCounter = 0;   
 
     unsigned int _userId = 0;
     unsigned int _userState = 0;
-    bool _enabled = true;
-
-
 
+    bool hasButton() { return haveButton; }
+    bool hasEncoder() { return haveEncoder; }
+    Bounce &buttonDriver() { return *bounce; }
+    Encoder &encoderDriver() { return *encoder; }
+    bool hasHandler(uint8_t type) { return handler(type) != NULL; }
+    void callHandler(uint8_t type) { handler(type)(*this); }
+    CallbackFunction &handler(uint8_t type);
 };
 
 #endif
-
-
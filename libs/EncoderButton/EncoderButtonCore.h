@@ -0,0 +1,470 @@
+/**
+ * Event state machine shared by EncoderButton and StaticEncoderButton.
+ *
+ * The core owns the click, long press, encoder and idle logic, the event
+ * queue and every timing setting, so both classes fire the same events at
+ * the same times. How the encoder, the button and the handlers are stored
+ * is left to the class deriving from it, which provides:
+ *
+ *   bool hasButton()             a button is attached
+ *   bool hasEncoder()            an encoder is attached
+ *   ButtonType &buttonDriver()   Bounce2 interface: update(), read(), fell(),
+ *                                rose(), interval(), currentDuration() and
+ *                                previousDuration()
+ *   Encoder &encoderDriver()
+ *   bool hasHandler(uint8_t type)  a handler is set for the event type
+ *   void callHandler(uint8_t type) call it
+ *
+ * GPLv2 Licence https://www.gnu.org/licenses/old-licenses/gpl-2.0.txt
+ */
+#pragma once
+
+#include <Encoder.h>
+#include <Bounce2.h>
+#include "SpscQueue.h"
+
+#define HIGH 0x1
+#define LOW  0x0
+
+#define INPUT 0x0
+#define OUTPUT 0x1
+#define INPUT_PULLUP 0x2
+
+typedef uint8_t byte;
+
+/**
+ * One fired event, as queued by update() in event queue mode
+ */
+struct EncoderButtonEvent {
+  enum Type : uint8_t {
+    CHANGED, PRESSED, RELEASED, CLICK, DOUBLE_CLICK, TRIPLE_CLICK,
+    LONG_CLICK, LONG_PRESS, ENCODER, ENCODER_PRESSED, ENCODER_RELEASED, IDLE
+  };
+  uint8_t type;
+  uint8_t clickCount;
+  uint8_t longPressCount;
+  int16_t increment;
+  uint32_t timestampMs;
+};
+
+/**
+ * Acceleration curve of one encoder handler, off by default.
+ * A detent turned within slowMs of the previous one counts for more than
+ * one step, linearly more down to fastMs, where it counts maxFactor steps.
+ * Turned slower the encoder stays 1:1. set() works out the slope, so
+ * apply() costs a multiply and a shift per event, and a division when the
+ * rate limit lets several detents through in one event.
+ */
+struct EncoderAcceleration {
+  uint16_t maxFactor = 1;
+  uint16_t slowMs = 0;
+  uint16_t fastMs = 0;
+  // extra steps per detent for every ms faster than slowMs, 1/256 step
+  uint32_t slopeQ8 = 0;
+
+  void set(uint16_t factor, uint16_t slow, uint16_t fast) {
+    maxFactor = factor > 1 ? factor : 1;
+    slowMs = slow;
+    fastMs = fast < slow ? fast : slow;
+    slopeQ8 = slowMs > fastMs
+        ? ((uint32_t)(maxFactor - 1) << 8) / (slowMs - fastMs) : 0;
+  }
+
+  /**
+   * Steps for detents turned over intervalMs since the previous event
+   */
+  int16_t apply(int32_t detents, uint32_t intervalMs) const {
+    const uint32_t count = detents < 0 ? -detents : detents;
+    if ( maxFactor <= 1 || count == 0 ) return (int16_t)detents;
+    // spacing of the detents of this event
+    const uint32_t spacingMs = count > 1 ? intervalMs / count : intervalMs;
+    if ( spacingMs >= slowMs ) return (int16_t)detents;
+    const uint32_t factorQ8 = spacingMs <= fastMs
+        ? (uint32_t)maxFactor << 8
+        : (1U << 8) + (slowMs - spacingMs) * slopeQ8;
+    uint32_t steps = (count * factorQ8 + 128) >> 8;
+    if ( steps > INT16_MAX ) steps = INT16_MAX;
+    return detents < 0 ? -(int16_t)steps : (int16_t)steps;
+  }
+};
+
+template <typename Derived>
+class EncoderButtonCore {
+
+  public:
+    typedef EncoderButtonEvent Event;
+
+    /**
+     * Read the position of the encoder and update the state of the button.
+     * Fires the handlers, or queues their events, see useEventQueue().
+     */
+    void update() {
+      if ( !_enabled ) return;
+      Derived &self = derived();
+      //button update (fires pressed/released handlers)
+      if ( self.hasButton() && self.buttonDriver().update() ) {
+        lastEventMs = millis();
+        idleFlagged = false;
+        fire(Event::CHANGED);
+        _buttonState = self.buttonDriver().read();
+        if ( self.buttonDriver().fell() ) {
+          previousState = HIGH;
+          fire(Event::PRESSED);
+        } else if ( self.buttonDriver().rose() ) {
+          if ( encodingPressed ) {
+            encodingPressed = false;
+            prevClickCount = 0;
+            clickCounter = 0;
+            fire(Event::ENCODER_RELEASED);
+          } else {
+            if ( previousState == HIGH ) {
+              clickFired = false;
+              clickCounter++;
+            }
+            fire(Event::RELEASED);
+          }
+          previousState = LOW;
+        }
+      }
+      //encoder update (fires encoder rotation handlers)
+      if ( self.hasEncoder() && millis() > (rateLimitCounter + rateLimit) ) {
+        // floor division, the position may be negative
+        const int32_t raw = self.encoderDriver().read();
+        const int32_t newPosition = raw >= 0
+            ? raw / positionDivider
+            : -((positionDivider - 1 - raw) / positionDivider);
+        if ( newPosition != encoderPosition ) {
+          const int32_t detents = newPosition - encoderPosition;
+          encoderPosition = newPosition;
+          idleFlagged = false;
+          lastEventMs = millis();
+          const unsigned long intervalMs = lastEventMs - lastDetentMs;
+          lastDetentMs = lastEventMs;
+          if ( _buttonState == HIGH ) {
+            encoderIncrement = encoderAcceleration.apply(detents, intervalMs);
+            currentPosition += encoderIncrement;
+            fire(Event::ENCODER);
+          } else {
+            encodingPressed = true;
+            encoderIncrement = encoderPressedAcceleration.apply(detents, intervalMs);
+            currentPressedPosition += encoderIncrement;
+            fire(Event::ENCODER_PRESSED);
+          }
+        }
+        rateLimitCounter = millis();
+      }
+      //fire long press handlers
+      if ( self.hasButton() && !encodingPressed && LOW == self.buttonDriver().read() ) {
+        if ( self.buttonDriver().currentDuration() > (longClickDuration * (longPressCounter+1)) ) {
+          lastEventMs = millis();
+          if ( repeatLongPress || longPressCounter == 0 ) {
+            fire(Event::LONG_PRESS);
+          }
+          longPressCounter++;
+        }
+      }
+      //fire button click handlers
+      if ( self.hasButton() && !clickFired && _buttonState == HIGH &&
+           self.buttonDriver().currentDuration() > multiClickInterval ) {
+        clickFired = true;
+        if ( self.buttonDriver().previousDuration() > longClickDuration ) {
+          clickCounter = 0;
+          prevClickCount = 1;
+          longPressCounter = 0;
+          fire(Event::LONG_CLICK);
+        } else {
+          prevClickCount = clickCounter;
+          if ( clickCounter == 3 && self.hasHandler(Event::TRIPLE_CLICK) ) {
+            fire(Event::TRIPLE_CLICK);
+          } else if ( clickCounter == 2 && self.hasHandler(Event::DOUBLE_CLICK) ) {
+            fire(Event::DOUBLE_CLICK);
+          } else {
+            fire(Event::CLICK);
+          }
+          clickCounter = 0;
+        }
+      }
+      //fire idle timeout handler
+      if ( !idleFlagged && self.hasHandler(Event::IDLE) && msSinceLastEvent() > idleTimeout ) {
+        idleFlagged = true;
+        fire(Event::IDLE);
+      }
+    }
+
+    /** ***************************************
+     *  button setup
+     */
+
+    /**
+     * Default is set in the Bounce2 library (currently 10ms)
+     */
+    void setDebounceInterval(unsigned int intervalMs) {
+      derived().buttonDriver().interval(intervalMs);
+    }
+
+    /**
+     * Set the interval in ms between double, triple or
+     * multi clicks
+     */
+    void setMultiClickInterval(unsigned int intervalMs) { multiClickInterval = intervalMs; }
+
+    /**
+     * Set the ms that defines a lonf click. Long pressed callback
+     * will be fired at this interval if repeat is set to true via the
+     * setLongPressHandler()
+     */
+    void setLongClickDuration(unsigned int longDurationMs) { longClickDuration = longDurationMs; }
+
+    /**
+     * Choose whether to repeat the long press callback
+     * (default is 'false')
+     */
+    void setLongPressRepeat(bool repeat=false) { repeatLongPress = repeat; }
+
+    /** ***************************************
+     *  encoder setup
+     */
+
+    /**
+     * Encoder callbacks are normally fired on every loop() but for MPG
+     * style encoders this can fire a huge number of events (that may
+     * swamp a serial connection).
+     * The encoder interupts will sitll be called but this will limit
+     * the call back firing to every set ms - read the
+     * EncoderButton.increment() for lossless counting of encoder.
+     * Set to zero (default) for no rate limit.
+     */
+    void setRateLimit(long ms) { rateLimit = ms; }
+
+    /**
+     * Quadrature encoders have four states for each 'click' of the
+     * rotary switch. By default we only fire once per click.
+     * Set this to 'true' if you want four events per click.
+     * Affects pressed+turning too.
+     */
+    void useQuadPrecision(bool prec) { positionDivider = (prec?1:4); }
+
+    /**
+     * Accelerate the encoder handler: a fast spin jumps by up to
+     * maxFactor steps per detent, see EncoderAcceleration. The position
+     * and increment() count the accelerated steps. A maxFactor of 1
+     * (default) turns it off.
+     * @param slowMs Detents further apart count one step
+     * @param fastMs Detents this close or closer count maxFactor steps
+     */
+    void setEncoderAcceleration(uint16_t maxFactor, uint16_t slowMs=100, uint16_t fastMs=10) {
+      encoderAcceleration.set(maxFactor, slowMs, fastMs);
+    }
+
+    /**
+     * Accelerate the encoder pressed handler, see setEncoderAcceleration()
+     */
+    void setEncoderPressedAcceleration(uint16_t maxFactor, uint16_t slowMs=100, uint16_t fastMs=10) {
+      encoderPressedAcceleration.set(maxFactor, slowMs, fastMs);
+    }
+
+    /**
+     * Reset the counted position of the encoder.
+     */
+    void resetPosition(long pos = 0) {
+      derived().encoderDriver().readAndReset();
+      encoderPosition = 0;
+      currentPosition = pos;
+    }
+
+    /**
+     * Reset the counted pressed position of the encoder.
+     */
+    void resetPressedPosition(long pos = 0) {
+      derived().encoderDriver().readAndReset();
+      encoderPosition = 0;
+      currentPressedPosition = pos;
+    }
+
+    /**
+     * Set the idle timeout in ms (default 10000)
+     */
+    void setIdleTimeout(unsigned int timeoutMs) { idleTimeout = timeoutMs; }
+
+    /** ***************************************
+     *  button state
+     */
+
+    /**
+     * Directly get the current button state from Bounce2
+     */
+    bool buttonState() { return derived().buttonDriver().read(); }
+
+    /**
+     * Directly get the duration of the button current state from Bounce2
+     */
+    unsigned long currentDuration() { return derived().buttonDriver().currentDuration(); }
+
+    /**
+     * Directly get the duration of the button previous state from Bounce2
+     */
+    unsigned long previousDuration() { return derived().buttonDriver().previousDuration(); }
+
+    /**
+     * The number of multi-clicks that have been fired in the clicked event
+     */
+    unsigned char clickCount() {
+      return dispatching ? dispatching->clickCount : prevClickCount;
+    }
+
+    /**
+     * The number of times the long press handler has  been fired in the
+     * button pressed event
+     */
+    uint8_t longPressCount() {
+      return dispatching ? dispatching->longPressCount : longPressCounter+1;
+    }
+
+    /**
+     * Returns true if pressed
+     */
+    bool isPressed() { return buttonState() == LOW; }
+
+    /** ***************************************
+     *  encoder state
+     */
+
+    /**
+     * Returns a positive (CW) or negative (CCW) integer. Is normally 1 or -1 but if your
+     * loop() has lots of processing, your Arduino is slow or you setRateLimit()
+     * this will report the actual number of increments made by the encoder since
+     * the last encoder handler event.
+     */
+    int16_t increment() {
+      return dispatching ? dispatching->increment : encoderIncrement;
+    }
+
+    /**
+     * The current position of the encoder. Can be reset by resetPosition()
+     */
+    long position() { return currentPosition; }
+
+    /**
+     * The current position of the encoder when pressed. Can be reset by resetPressedPosition()
+     */
+    long pressedPosition() { return currentPressedPosition; }
+
+    /** ***************************************
+     * Returns the number of ms since any event was fired for this encoder/button
+     */
+    unsigned long msSinceLastEvent() { return millis() - lastEventMs; }
+
+    /**
+     * Returns true if enabled
+     */
+    bool enabled() { return _enabled; }
+
+    /**
+     * Set enabled to true of false
+     * This will enable/disable all event callbacks.
+     * When disabled the encoder positions will not be updated.
+     */
+    void enable(bool e=true) {
+      _enabled = e;
+      if ( e && derived().hasEncoder() ) {
+        //Reset the encoder so we don't trigger an event
+        derived().encoderDriver().write(encoderPosition*positionDivider);
+      }
+    }
+
+    /** ***************************************
+     *  event queue
+     */
+
+    /**
+     * In event queue mode update() does not call the handlers, it only
+     * queues a compact record of every event which has one set. dispatch()
+     * calls them later, typically from loop(). Use it when update() runs
+     * from a timer interrupt: the interrupt stays short and the handlers
+     * run in thread context, where they can safely use the display.
+     * While a handler runs from dispatch(), increment(), clickCount(),
+     * longPressCount() and eventMs() describe the queued event.
+     * The queue is lock-free with update() as the only producer and
+     * dispatch() as the only consumer.
+     */
+    void useEventQueue(bool queue=true) { queueEvents = queue; }
+
+    /**
+     * Call the handlers of the queued events, in order
+     */
+    void dispatch() {
+      Event event;
+      while ( events.pop(event) ) {
+        const uint8_t type = event.type % EVENTS;
+        if ( !derived().hasHandler(type) ) continue;
+        dispatching = &event;
+        derived().callHandler(type);
+        dispatching = nullptr;
+      }
+    }
+
+    /**
+     * Events dropped because the queue was full
+     */
+    uint32_t droppedEvents() { return events.overruns(); }
+
+    /**
+     * Time of the event being handled, in ms since boot
+     */
+    unsigned long eventMs() {
+      return dispatching ? dispatching->timestampMs : millis();
+    }
+
+  protected:
+    static const uint8_t EVENTS = Event::IDLE + 1;
+
+  private:
+    static const size_t EVENT_QUEUE_LENGTH = 16;
+
+    Derived &derived() { return static_cast<Derived &>(*this); }
+
+    void fire(Event::Type type) {
+      if ( !derived().hasHandler(type) ) return;
+      if ( !queueEvents ) {
+        derived().callHandler(type);
+        return;
+      }
+      Event event;
+      event.type = type;
+      event.clickCount = prevClickCount;
+      event.longPressCount = (uint8_t)(longPressCounter + 1);
+      event.increment = (int16_t)encoderIncrement;
+      event.timestampMs = (uint32_t)millis();
+      events.push(event);
+    }
+
+    SpscQueue<Event, EVENT_QUEUE_LENGTH> events;
+    volatile bool queueEvents = false;
+    // event dispatch() is handling, NULL outside of it
+    const Event *dispatching = nullptr;
+
+    uint8_t positionDivider = 4;
+    int32_t encoderPosition = 0;
+    int32_t currentPosition = 0;
+    int32_t currentPressedPosition = 0;
+    int encoderIncrement = 0;
+    bool encodingPressed = false;
+    unsigned char _buttonState = HIGH;
+    unsigned int multiClickInterval = 250;
+    unsigned int longClickDuration = 750;
+    bool clickFired = true;
+    unsigned char clickCounter = 0;
+    unsigned int longPressCounter = 0;
+    unsigned long lastEventMs = millis();
+    unsigned long idleTimeout = 10000;
+    bool idleFlagged = false;
+    bool previousState = LOW;
+    unsigned char prevClickCount = 0;
+    bool repeatLongPress = false;
+    unsigned int rateLimit = 0;
+    unsigned long rateLimitCounter = 0;
+    EncoderAcceleration encoderAcceleration;
+    EncoderAcceleration encoderPressedAcceleration;
+    unsigned long lastDetentMs = 0;
+    bool _enabled = true;
+};
@@ -0,0 +1,85 @@
+/**
+ * Allocation-free variant of EncoderButton for a rotary encoder with a
+ * button, same events and timing.
+ *
+ * The pins are template parameters, the Encoder and the button debouncer
+ * are members, and every handler is a plain function pointer with a
+ * void* context instead of a std::function. Nothing is allocated, an
+ * object is a few hundred bytes with its event queue, and a handler can
+ * be any captureless lambda.
+ *
+ * GPLv2 Licence https://www.gnu.org/licenses/old-licenses/gpl-2.0.txt
+ */
+#pragma once
+
+#include "EncoderButtonCore.h"
+
+/**
+ * The events and their timing come from EncoderButtonCore, see there for
+ * the setup, state and event queue functions.
+ * @tparam EncoderPin1 Encoder phase 1
+ * @tparam EncoderPin2 Encoder phase 2
+ * @tparam SwitchPin Push button, to ground, pulled up
+ * @tparam ButtonT Debouncer of the button, Bounce2 interface:
+ * attach(), interval(), update(), read(), fell(), rose(),
+ * currentDuration() and previousDuration()
+ */
+template <byte EncoderPin1, byte EncoderPin2, byte SwitchPin,
+          typename ButtonT = Bounce>
+class StaticEncoderButton
+    : public EncoderButtonCore<StaticEncoderButton<EncoderPin1, EncoderPin2,
+                                                   SwitchPin, ButtonT>> {
+    typedef EncoderButtonCore<StaticEncoderButton> Core;
+
+  public:
+    typedef void (*Handler)(StaticEncoderButton &btn, void *context);
+    typedef EncoderButtonEvent Event;
+
+    StaticEncoderButton() : encoder(EncoderPin1, EncoderPin2) {
+      button.attach(SwitchPin, INPUT_PULLUP);
+    }
+
+    /** ***************************************************
+     * set handlers, context is passed back to the handler
+     */
+    void setHandler(Event::Type type, Handler f, void *context = nullptr) {
+      handlers[type].fn = f;
+      handlers[type].context = context;
+    }
+    void setChangedHandler(Handler f, void *context = nullptr) { setHandler(Event::CHANGED, f, context); }
+    void setPressedHandler(Handler f, void *context = nullptr) { setHandler(Event::PRESSED, f, context); }
+    void setReleasedHandler(Handler f, void *context = nullptr) { setHandler(Event::RELEASED, f, context); }
+    void setClickHandler(Handler f, void *context = nullptr) { setHandler(Event::CLICK, f, context); }
+    void setDoubleClickHandler(Handler f, void *context = nullptr) { setHandler(Event::DOUBLE_CLICK, f, context); }
+    void setTripleClickHandler(Handler f, void *context = nullptr) { setHandler(Event::TRIPLE_CLICK, f, context); }
+    void setLongClickHandler(Handler f, void *context = nullptr) { setHandler(Event::LONG_CLICK, f, context); }
+    void setLongPressHandler(Handler f, void *context = nullptr, bool repeat = false) {
+      setHandler(Event::LONG_PRESS, f, context);
+      Core::setLongPressRepeat(repeat);
+    }
+    void setEncoderHandler(Handler f, void *context = nullptr) { setHandler(Event::ENCODER, f, context); }
+    void setEncoderPressedHandler(Handler f, void *context = nullptr) { setHandler(Event::ENCODER_PRESSED, f, context); }
+    void setEncoderReleasedHandler(Handler f, void *context = nullptr) { setHandler(Event::ENCODER_RELEASED, f, context); }
+    void setIdleHandler(Handler f, void *context = nullptr) { setHandler(Event::IDLE, f, context); }
+
+  private:
+    friend Core;
+
+    struct Delegate {
+      Handler fn;
+      void *context;
+    };
+
+    static constexpr bool hasButton() { return true; }
+    static constexpr bool hasEncoder() { return true; }
+    ButtonT &buttonDriver() { return button; }
+    Encoder &encoderDriver() { return encoder; }
+    bool hasHandler(uint8_t type) { return handlers[type].fn != nullptr; }
+    void callHandler(uint8_t type) {
+      handlers[type].fn(*this, handlers[type].context);
+    }
+
+    Encoder encoder;
+    ButtonT button;
+    Delegate handlers[Core::EVENTS] = {};
+};
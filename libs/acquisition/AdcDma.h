@@ -0,0 +1,134 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include "AdcDmaHal.h"
+
+/// @brief Mask of the conversion result, bit 15 is the ADC error flag
+constexpr uint16_t ADC_RESULT_MASK = 0x0FFFU;
+
+/// @brief Block of conversions completed by the DMA
+struct AdcBlock {
+    const uint16_t *samples;  ///< Interleaved samples, lowest input first
+    size_t count;             ///< Number of samples in the block
+    uint64_t timestamp_us;    ///< Time the last conversion has completed
+    uint32_t sequence;        ///< Block number since start()
+};
+
+/// @brief Free-running ADC acquisition streamed by DMA into a block ring
+/// @details The ADC runs in round-robin mode and two chained DMA channels
+/// take turns filling blocks of the ring, so the CPU is interrupted once per
+/// block only. The ring is a single-producer (IRQ) single-consumer queue of
+/// whole blocks. When the consumer falls behind, new blocks are dropped into
+/// a scratch buffer and counted as overruns, blocks already handed out are
+/// never overwritten.
+/// @tparam BlockSamples Number of samples (all inputs) in one block
+/// @tparam Blocks Number of blocks in the ring, power of two
+template <size_t BlockSamples, size_t Blocks>
+class AdcDma {
+    static_assert(Blocks >= 4 && (Blocks & (Blocks - 1)) == 0,
+                  "Blocks must be a power of two, at least 4");
+
+public:
+    typedef void (*BlockCallback)();
+
+    /// @brief Configure ADC and DMA, conversions are not started yet
+    /// @param input_mask Bit mask of ADC inputs to convert in round robin
+    /// @param sample_rate_hz Total conversion rate over all inputs
+    /// @param callback Called from IRQ context after every block, optional
+    /// @return True if hardware has been configured
+    bool begin(uint32_t input_mask, uint32_t sample_rate_hz,
+               BlockCallback callback = nullptr) {
+        _callback = callback;
+        for (size_t i = 0; i < Blocks; ++i) {
+            _blocks[i].samples = _buffers[i];
+            _blocks[i].count = BlockSamples;
+        }
+        return adc_dma_hal::init(input_mask, sample_rate_hz, on_complete,
+                                 this);
+    }
+
+    /// @brief Start conversions with an empty ring
+    void start() {
+        _head.store(0, std::memory_order_relaxed);
+        _tail.store(0, std::memory_order_relaxed);
+        _armed[0] = 0;
+        _armed[1] = 1;
+        _armed_valid[0] = _armed_valid[1] = true;
+        _next = 2;
+        adc_dma_hal::start(_buffers[0], _buffers[1], BlockSamples);
+    }
+
+    /// @brief Stop conversions, blocks in the ring stay readable
+    void stop() { adc_dma_hal::stop(); }
+
+    /// @brief Get the oldest completed block
+    /// @return Block or nullptr if there is none, must be released
+    const AdcBlock *acquire() const {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return nullptr;
+        return &_blocks[tail & (Blocks - 1)];
+    }
+
+    /// @brief Give the block returned by acquire() back to the DMA
+    void release() {
+        _tail.store(_tail.load(std::memory_order_relaxed) + 1,
+                    std::memory_order_release);
+    }
+
+    /// @brief Number of blocks waiting for the consumer
+    uint32_t pending() const {
+        return _head.load(std::memory_order_acquire) -
+               _tail.load(std::memory_order_relaxed);
+    }
+
+    /// @brief Number of blocks completed since start()
+    uint32_t blocks() const { return _head.load(std::memory_order_relaxed); }
+
+    /// @brief Number of blocks dropped because the ring was full
+    uint32_t overruns() const {
+        return _overruns.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void on_complete(unsigned chain, void *context) {
+        static_cast<AdcDma *>(context)->complete(chain);
+    }
+
+    void complete(unsigned chain) {
+        if (_armed_valid[chain]) {
+            AdcBlock &block = _blocks[_armed[chain] & (Blocks - 1)];
+            block.timestamp_us = adc_dma_hal::now_us();
+            block.sequence = _armed[chain];
+            _head.store(_armed[chain] + 1, std::memory_order_release);
+        }
+
+        // The other chain is already running, re-arm this one for the block
+        // after it
+        if (_next - _tail.load(std::memory_order_acquire) < Blocks) {
+            adc_dma_hal::arm(chain, _buffers[_next & (Blocks - 1)]);
+            _armed[chain] = _next++;
+            _armed_valid[chain] = true;
+        } else {
+            adc_dma_hal::arm(chain, _scratch);
+            _armed_valid[chain] = false;
+            _overruns.store(_overruns.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+        }
+
+        if (_callback) _callback();
+    }
+
+    uint16_t _buffers[Blocks][BlockSamples];
+    uint16_t _scratch[BlockSamples];
+    AdcBlock _blocks[Blocks];
+    uint32_t _armed[2] = {0, 0};
+    bool _armed_valid[2] = {false, false};
+    uint32_t _next = 0;
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _overruns{0};
+    BlockCallback _callback = nullptr;
+};
@@ -0,0 +1,42 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Thin hardware layer used by AdcDma.
+/// @details Two DMA channels ("chains" 0 and 1) are triggered by the ADC
+/// FIFO and chained to each other, so while one channel fills a block the
+/// other one is already armed with the next destination. Every completed
+/// block raises one interrupt which calls the completion handler with the
+/// index of the chain that has just finished.
+namespace adc_dma_hal {
+
+typedef void (*CompletionHandler)(unsigned chain, void *context);
+
+/// @brief Configure ADC free-running round-robin mode and claim DMA channels
+/// @param input_mask Bit mask of ADC inputs (bit 0 = ADC0/GPIO26 ...)
+/// @param sample_rate_hz Total conversion rate over all inputs
+/// @param handler Called from IRQ context when a chain finishes a block
+/// @param context User pointer passed to the handler
+/// @return True if hardware has been configured
+bool init(uint32_t input_mask, uint32_t sample_rate_hz,
+          CompletionHandler handler, void *context);
+
+/// @brief Set destination of the next transfer of given chain
+/// @details Must be called from the completion handler only, while the
+/// chain is idle.
+void arm(unsigned chain, uint16_t *dst);
+
+/// @brief Start conversions, chain 0 writes first, chain 1 next
+/// @param first Destination of chain 0
+/// @param second Destination of chain 1
+/// @param count Number of samples per block
+void start(uint16_t *first, uint16_t *second, size_t count);
+
+/// @brief Stop conversions and abort transfers
+void stop();
+
+/// @brief Microsecond timestamp used to stamp completed blocks
+uint64_t now_us();
+
+}  // namespace adc_dma_hal
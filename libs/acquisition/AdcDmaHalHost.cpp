@@ -0,0 +1,74 @@
+#include "AdcDmaHal.h"
+#include "HalHost.h"
+
+namespace adc_dma_hal {
+
+namespace {
+
+uint32_t s_input_mask = 0;
+uint32_t s_period_ns = 0;
+uint64_t s_start_us = 0;
+uint64_t s_samples = 0;  // conversions since start()
+unsigned s_next_input = 0;
+unsigned s_active_chain = 0;
+size_t s_count = 0;
+uint16_t *s_dst[2] = {nullptr, nullptr};
+CompletionHandler s_handler = nullptr;
+void *s_context = nullptr;
+
+unsigned next_input(unsigned input) {
+    do {
+        input = (input + 1U) & 3U;
+    } while (!(s_input_mask & (1U << input)));
+    return input;
+}
+
+uint64_t sample_time_us(uint64_t sample) {
+    return s_start_us + sample * s_period_ns / 1000U;
+}
+
+// The DMA completes a block once its last conversion is done, the samples
+// are taken from the analog source at their own conversion times
+uint64_t block_done(void *, uint64_t) {
+    uint16_t *dst = s_dst[s_active_chain];
+    for (size_t i = 0; i < s_count; ++i) {
+        dst[i] = hal::host::analog_sample(s_next_input,
+                                          sample_time_us(s_samples++));
+        s_next_input = next_input(s_next_input);
+    }
+    const unsigned done = s_active_chain;
+    s_active_chain ^= 1U;
+    s_handler(done, s_context);
+    return sample_time_us(s_samples + s_count);
+}
+
+}  // namespace
+
+bool init(uint32_t input_mask, uint32_t sample_rate_hz,
+          CompletionHandler handler, void *context) {
+    if (!(input_mask & 0xFU) || !sample_rate_hz || !handler) return false;
+    s_input_mask = input_mask & 0xFU;
+    s_period_ns = 1000000000U / sample_rate_hz;
+    s_handler = handler;
+    s_context = context;
+    return true;
+}
+
+void arm(unsigned chain, uint16_t *dst) { s_dst[chain] = dst; }
+
+void start(uint16_t *first, uint16_t *second, size_t count) {
+    s_dst[0] = first;
+    s_dst[1] = second;
+    s_count = count;
+    s_active_chain = 0;
+    s_next_input = __builtin_ctz(s_input_mask);
+    s_start_us = hal::time_us();
+    s_samples = 0;
+    hal::host::schedule(sample_time_us(count), block_done, nullptr);
+}
+
+void stop() { hal::host::unschedule(block_done, nullptr); }
+
+uint64_t now_us() { return hal::time_us(); }
+
+}  // namespace adc_dma_hal
@@ -0,0 +1,93 @@
+#include "AdcDmaHal.h"
+
+#include "hardware/adc.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+#include "pico/stdlib.h"
+
+namespace adc_dma_hal {
+
+namespace {
+
+constexpr uint32_t ADC_CLOCK_HZ = 48000000U;
+
+int s_channel[2] = {-1, -1};
+CompletionHandler s_handler = nullptr;
+void *s_context = nullptr;
+
+void dma_irq_handler() {
+    for (unsigned chain = 0; chain < 2; ++chain) {
+        const uint ch = (uint)s_channel[chain];
+        if (dma_channel_get_irq0_status(ch)) {
+            dma_channel_acknowledge_irq0(ch);
+            s_handler(chain, s_context);
+        }
+    }
+}
+
+}  // namespace
+
+bool init(uint32_t input_mask, uint32_t sample_rate_hz,
+          CompletionHandler handler, void *context) {
+    if (!input_mask || !sample_rate_hz || !handler) return false;
+
+    for (unsigned input = 0; input < 4; ++input) {
+        if (input_mask & (1U << input)) adc_gpio_init(26 + input);
+    }
+    // Round robin always restarts from the lowest selected input
+    adc_select_input(__builtin_ctz(input_mask));
+    adc_set_round_robin(input_mask);
+    // FIFO with DREQ at one sample, error flag in bit 15, no 8-bit shift
+    adc_fifo_setup(true, true, 1, true, false);
+    adc_set_clkdiv((float)(ADC_CLOCK_HZ / sample_rate_hz) - 1.0f);
+
+    s_channel[0] = dma_claim_unused_channel(true);
+    s_channel[1] = dma_claim_unused_channel(true);
+    s_handler = handler;
+    s_context = context;
+
+    for (unsigned chain = 0; chain < 2; ++chain) {
+        dma_channel_config cfg = dma_channel_get_default_config(s_channel[chain]);
+        channel_config_set_transfer_data_size(&cfg, DMA_SIZE_16);
+        channel_config_set_read_increment(&cfg, false);
+        channel_config_set_write_increment(&cfg, true);
+        channel_config_set_dreq(&cfg, DREQ_ADC);
+        channel_config_set_chain_to(&cfg, s_channel[chain ^ 1U]);
+        dma_channel_set_config(s_channel[chain], &cfg, false);
+        dma_channel_set_read_addr(s_channel[chain], &adc_hw->fifo, false);
+        dma_channel_set_irq0_enabled(s_channel[chain], true);
+    }
+
+    irq_add_shared_handler(DMA_IRQ_0, dma_irq_handler,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+    return true;
+}
+
+void arm(unsigned chain, uint16_t *dst) {
+    dma_channel_set_write_addr(s_channel[chain], dst, false);
+}
+
+void start(uint16_t *first, uint16_t *second, size_t count) {
+    adc_run(false);
+    adc_fifo_drain();
+    dma_channel_set_trans_count(s_channel[1], count, false);
+    dma_channel_set_write_addr(s_channel[1], second, false);
+    dma_channel_set_trans_count(s_channel[0], count, false);
+    dma_channel_set_write_addr(s_channel[0], first, true);
+    adc_run(true);
+}
+
+void stop() {
+    adc_run(false);
+    // Abort both at once, aborting one alone would trigger its chain partner
+    const uint32_t mask = (1U << s_channel[0]) | (1U << s_channel[1]);
+    dma_hw->abort = mask;
+    while (dma_hw->abort & mask) tight_loop_contents();
+    dma_hw->ints0 = mask;
+    adc_fifo_drain();
+}
+
+uint64_t now_us() { return time_us_64(); }
+
+}  // namespace adc_dma_hal
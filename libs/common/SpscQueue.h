@@ -0,0 +1,65 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+/// @brief Wait-free single-producer single-consumer ring
+/// @details One side may run in an IRQ handler or on the other core, the
+/// other side in thread context. Only plain 32-bit atomic loads and stores
+/// are used, so it is lock-free on the Cortex-M0+ as well (no LDREX/STREX
+/// there). A full queue rejects the new item and counts an overrun, items
+/// already queued are never overwritten.
+/// @tparam T Trivially copyable item type
+/// @tparam Capacity Number of items, power of two
+template <typename T, size_t Capacity>
+class SpscQueue {
+    static_assert(Capacity >= 2 && (Capacity & (Capacity - 1)) == 0,
+                  "Capacity must be a power of two");
+
+public:
+    /// @brief Append item, producer side only
+    /// @return False if the queue was full and the item was dropped
+    bool push(const T &item) {
+        const uint32_t head = _head.load(std::memory_order_relaxed);
+        if (head - _tail.load(std::memory_order_acquire) >= Capacity) {
+            _overruns.store(_overruns.load(std::memory_order_relaxed) + 1,
+                            std::memory_order_relaxed);
+            return false;
+        }
+        _items[head & (Capacity - 1)] = item;
+        _head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Take the oldest item, consumer side only
+    /// @return False if the queue was empty
+    bool pop(T &item) {
+        const uint32_t tail = _tail.load(std::memory_order_relaxed);
+        if (tail == _head.load(std::memory_order_acquire)) return false;
+        item = _items[tail & (Capacity - 1)];
+        _tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /// @brief Number of queued items, exact on the consumer side only
+    size_t size() const {
+        return _head.load(std::memory_order_acquire) -
+               _tail.load(std::memory_order_acquire);
+    }
+
+    bool empty() const { return size() == 0; }
+
+    /// @brief Number of items dropped because the queue was full
+    uint32_t overruns() const {
+        return _overruns.load(std::memory_order_relaxed);
+    }
+
+    static constexpr size_t capacity() { return Capacity; }
+
+private:
+    T _items[Capacity];
+    std::atomic<uint32_t> _head{0};
+    std::atomic<uint32_t> _tail{0};
+    std::atomic<uint32_t> _overruns{0};
+};
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Cascaded integrator-comb decimator for raw ADC counts
+/// @details Order integrators run at the input rate, Order combs (delay 1)
+/// at the output rate, so the filter costs Order additions per input sample
+/// and no multiply. The registers wrap modulo 2^32, which the CIC tolerates
+/// as long as the gain Ratio^Order times the input range fits in 32 bits.
+/// The comb output is divided by the gain once per output sample and kept
+/// with FracBits extra bits: averaging Ratio samples of a noisy (dithered)
+/// input gains up to log2(sqrt(Ratio)) bits of resolution.
+/// The response is sinc^Order: unity at DC, a few mdB down across the
+/// band of interest when the output rate is well above the signal, and
+/// nulls on every multiple of the output rate, where the aliases would
+/// fold from.
+/// @tparam Order Number of integrator/comb stages
+/// @tparam Ratio Decimation ratio
+/// @tparam FracBits Extra output bits below the input LSB
+template <unsigned Order, unsigned Ratio, unsigned FracBits>
+class CicDecimator {
+    static constexpr uint64_t gain() {
+        uint64_t g = 1;
+        for (unsigned i = 0; i < Order; i++) g *= Ratio;
+        return g;
+    }
+
+    static_assert(Order >= 1 && Ratio >= 2, "nothing to decimate");
+    static_assert(gain() * 4096U <= (1ULL << 32),
+                  "register growth exceeds 32 bits for 12-bit input");
+    static_assert(FracBits <= 4, "output must fit 16 bits");
+
+public:
+    static constexpr uint64_t GAIN = gain();
+
+    /// @brief Feed one input sample
+    /// @return True when an output sample is ready in output()
+    bool push(uint16_t x) {
+        uint32_t acc = x;
+        for (unsigned i = 0; i < Order; i++) {
+            _integrator[i] += acc;
+            acc = _integrator[i];
+        }
+        if (++_phase < Ratio) return false;
+        _phase = 0;
+
+        for (unsigned i = 0; i < Order; i++) {
+            const uint32_t delayed = _comb[i];
+            _comb[i] = acc;
+            acc -= delayed;
+        }
+        // the first Order outputs still see the integrators starting up
+        if (_settle < Order) {
+            _settle++;
+            return false;
+        }
+        _output = (uint16_t)((((uint64_t)acc << FracBits) + GAIN / 2) / GAIN);
+        return true;
+    }
+
+    /// @brief Latest output, input units << FracBits
+    uint16_t output() const { return _output; }
+
+private:
+    uint32_t _integrator[Order] = {};
+    uint32_t _comb[Order] = {};
+    unsigned _phase = 0;
+    unsigned _settle = 0;
+    uint16_t _output = 0;
+};
@@ -0,0 +1,131 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Statistics of one engine cycle of one channel, in input units
+struct CycleStats {
+    uint32_t period;  // samples from the previous pulse start
+    uint16_t mean;
+    uint16_t min;     // deepest point of the intake pulse
+    uint16_t max;
+};
+
+/// @brief Cycle-synchronous averaging of an intake vacuum channel
+/// @details The runner pressure drops once per engine cycle, while the
+/// intake valve is open. A pulse starts when the signal falls a hysteresis
+/// below the centre line and the detector re-arms once it is back above it.
+/// The centre is the mean of the previous cycle (a slow moving average
+/// until there is one) and the hysteresis a quarter of that cycle's swing,
+/// so the thresholds follow the engine without tuning. Starts closer than
+/// half the previous period are ignored, which keeps ignition spikes and
+/// ringing on the pulse edge from splitting a cycle. Every sample between
+/// two pulse starts goes into that cycle's mean, min and max: the mean of
+/// a whole cycle does not beat against the engine like a fixed window does.
+/// O(1) integer work per sample, meant for the acquisition IRQ.
+class CycleAverager {
+public:
+    /// @param min_period Shortest accepted cycle, samples (highest RPM)
+    /// @param max_period Longest cycle, samples; without a pulse start for
+    /// that long the lock is lost
+    /// @param min_hysteresis Lower bound of the hysteresis, input units,
+    /// above the noise floor
+    constexpr CycleAverager(uint32_t min_period, uint32_t max_period,
+                            uint16_t min_hysteresis)
+        : _minPeriod(min_period),
+          _maxPeriod(max_period),
+          _minHysteresis(min_hysteresis) {}
+
+    /// @brief Feed one sample
+    /// @return True if it started a new pulse and completed a cycle, whose
+    /// statistics are then in last()
+    bool push(uint16_t x) {
+        if (!_primed) {
+            _ema = (uint32_t)x << EMA_SHIFT;
+            _primed = true;
+        }
+        _ema += x - (int32_t)(_ema >> EMA_SHIFT);
+
+        bool complete = false;
+        if (detect(x)) {
+            if (_armed) {
+                _last = {_count, (uint16_t)(_sum / _count), _min, _max};
+                _locked = true;
+                complete = true;
+            }
+            _armed = true;
+            startCycle();
+        }
+        if (_armed) {
+            accumulate(x);
+            if (_count > _maxPeriod) reset();
+        }
+        return complete;
+    }
+
+    /// @brief Statistics of the most recent complete cycle
+    const CycleStats &last() const { return _last; }
+
+    /// @brief True while cycles complete within max_period
+    bool locked() const { return _locked; }
+
+    void reset() {
+        _locked = false;
+        _armed = false;
+        _high = false;
+        _count = 0;
+        _last = {};
+    }
+
+private:
+    // moving average over ~512 samples for the first cycle
+    static constexpr unsigned EMA_SHIFT = 9;
+
+    bool detect(uint16_t x) {
+        const int32_t centre =
+            _locked ? _last.mean : (int32_t)(_ema >> EMA_SHIFT);
+        int32_t hysteresis = _locked ? (_last.max - _last.min) / 4 : 0;
+        if (hysteresis < _minHysteresis) hysteresis = _minHysteresis;
+
+        if (x >= centre) {
+            _high = true;
+            return false;
+        }
+        if (!_high || x >= centre - hysteresis) return false;
+        const uint32_t refractory = _locked ? _last.period / 2 : _minPeriod;
+        if (_armed && _count < (refractory > _minPeriod ? refractory
+                                                        : _minPeriod)) {
+            _high = false;  // needs a fresh rise past the centre
+            return false;
+        }
+        _high = false;
+        return true;
+    }
+
+    void startCycle() {
+        _sum = 0;
+        _count = 0;
+        _min = UINT16_MAX;
+        _max = 0;
+    }
+
+    void accumulate(uint16_t x) {
+        _sum += x;
+        _count++;
+        if (x < _min) _min = x;
+        if (x > _max) _max = x;
+    }
+
+    uint32_t _minPeriod;
+    uint32_t _maxPeriod;
+    uint16_t _minHysteresis;
+    uint32_t _ema = 0;
+    uint32_t _sum = 0;
+    uint32_t _count = 0;
+    uint16_t _min = UINT16_MAX;
+    uint16_t _max = 0;
+    bool _primed = false;
+    bool _high = false;
+    bool _armed = false;
+    bool _locked = false;
+    CycleStats _last = {};
+};
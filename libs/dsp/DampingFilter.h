@@ -0,0 +1,137 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Damping of one pressure channel, like the damper of a needle gauge
+/// @details Integer only, O(1) per sample:
+///  - LIGHT, MEDIUM, HEAVY: first-order IIR, y += (x - y) / 2^k, with time
+///    constants of about 0.1, 0.5 and 2 s
+///  - NEEDLE: two equal first-order stages in series, a critically damped
+///    second-order response: it settles without overshoot and ignores fast
+///    pulsation better than one stage with the same delay
+/// The mode may be requested from another context, eg. an encoder IRQ;
+/// push() picks it up and restarts from the current sample, so a switch
+/// never shows the old mode's history.
+/// @tparam SampleRate Samples per second of the channel
+template <unsigned SampleRate>
+class DampingFilter {
+public:
+    enum Mode : uint8_t { OFF, LIGHT, MEDIUM, HEAVY, NEEDLE, MODES };
+
+    /// @brief Short name of a mode, for the display
+    static const char *name(uint8_t mode) {
+        static const char *const c_NAMES[MODES] = {
+            "Off", "Light  0.1 s", "Medium 0.5 s", "Heavy    2 s",
+            "Needle 0.5 s"};
+        return mode < MODES ? c_NAMES[mode] : "";
+    }
+
+    void setMode(uint8_t mode) { _requested = mode < MODES ? mode : OFF; }
+
+    uint8_t mode() const { return _requested; }
+
+    /// @brief Filter one sample
+    /// @return Damped value, in the input units
+    uint16_t push(uint16_t x) {
+        const uint8_t mode = _requested;
+        if (mode != _mode || !_primed) restart(mode, x);
+
+        switch (_mode) {
+            case LIGHT:
+                return stage(_state[0], x, LIGHT_SHIFT);
+            case MEDIUM:
+                return stage(_state[0], x, MEDIUM_SHIFT);
+            case HEAVY:
+                return stage(_state[0], x, HEAVY_SHIFT);
+            case NEEDLE:
+                return stage(_state[1], stage(_state[0], x, NEEDLE_SHIFT),
+                             NEEDLE_SHIFT);
+            default:
+                return x;
+        }
+    }
+
+private:
+    static constexpr unsigned FRAC_BITS = 8;
+
+    /// @brief k of the 2^k-sample time constant nearest to tau_ms
+    static constexpr unsigned shift_for(unsigned tau_ms) {
+        unsigned k = 0;
+        // compare 2^k / SampleRate with tau on a log scale, sqrt(2) apart
+        while (k < 16 && (uint64_t)(1U << k) * 1000U * 1414U <
+                             (uint64_t)tau_ms * SampleRate * 1000U) {
+            k++;
+        }
+        return k;
+    }
+
+    static constexpr unsigned LIGHT_SHIFT = shift_for(100);
+    static constexpr unsigned MEDIUM_SHIFT = shift_for(500);
+    static constexpr unsigned HEAVY_SHIFT = shift_for(2000);
+    // each stage a quarter second, half a second in total
+    static constexpr unsigned NEEDLE_SHIFT = shift_for(250);
+
+    static uint16_t stage(int32_t &state, uint16_t x, unsigned shift) {
+        state += (((int32_t)x << FRAC_BITS) - state) >> shift;
+        return (uint16_t)((state + (1 << (FRAC_BITS - 1))) >> FRAC_BITS);
+    }
+
+    void restart(uint8_t mode, uint16_t x) {
+        _mode = mode;
+        _primed = true;
+        _state[0] = _state[1] = (int32_t)x << FRAC_BITS;
+    }
+
+    volatile uint8_t _requested = OFF;
+    uint8_t _mode = OFF;
+    bool _primed = false;
+    int32_t _state[2] = {};
+};
+
+/// @brief Median of the last 5 samples, rejects ignition spikes
+/// @details Meant for the raw samples: a spike of one or two conversions
+/// is dropped while the intake pulses, many samples long, keep their shape.
+/// 7 compare-exchanges per sample. Disabled it passes samples through and
+/// keeps its window current, so enabling it never shows stale samples.
+class SpikeFilter {
+public:
+    void setEnabled(bool enabled) { _enabled = enabled; }
+
+    bool enabled() const { return _enabled; }
+
+    uint16_t push(uint16_t x) {
+        _window[_next] = x;
+        _next = _next + 1 < MEDIAN ? _next + 1 : 0;
+        return _enabled ? median() : x;
+    }
+
+private:
+    static constexpr uint8_t MEDIAN = 5;
+
+    // median of 5 by a selection network, 7 compare-exchanges
+    uint16_t median() const {
+        uint16_t a = _window[0], b = _window[1], c = _window[2],
+                 d = _window[3], e = _window[4];
+        auto order = [](uint16_t &lo, uint16_t &hi) {
+            if (hi < lo) {
+                const uint16_t t = lo;
+                lo = hi;
+                hi = t;
+            }
+        };
+        order(a, b);
+        order(d, e);
+        // a is now below three others and e above three, neither can be
+        // the median
+        order(a, d);
+        order(b, e);
+        order(b, c);
+        order(c, d);
+        order(b, c);
+        return c;
+    }
+
+    volatile bool _enabled = false;
+    uint16_t _window[MEDIAN] = {};
+    uint8_t _next = 0;
+};
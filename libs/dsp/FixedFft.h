@@ -0,0 +1,126 @@
+#pragma once
+
+#include <cstdint>
+
+namespace fft_detail {
+
+constexpr double PI = 3.14159265358979323846;
+
+/// @brief sin(x) by its Taylor series, compile time only
+constexpr double sin_series(double x) {
+    // reduce to [-pi, pi] where 15 terms are far below Q15 resolution
+    while (x > PI) x -= 2 * PI;
+    while (x < -PI) x += 2 * PI;
+    double term = x;
+    double sum = x;
+    for (int i = 1; i < 15; i++) {
+        term *= -x * x / ((2 * i) * (2 * i + 1));
+        sum += term;
+    }
+    return sum;
+}
+
+constexpr int16_t to_q15(double value) {
+    const double scaled = value * 32768.0;
+    if (scaled >= 32767.0) return 32767;
+    if (scaled <= -32767.0) return -32767;
+    return (int16_t)(scaled + (scaled < 0 ? -0.5 : 0.5));
+}
+
+/// @brief cos and sin of 2*pi*k/N for the first half turn, in Q15
+template <unsigned N>
+struct Twiddles {
+    int16_t cos[N / 2];
+    int16_t sin[N / 2];
+};
+
+template <unsigned N>
+constexpr Twiddles<N> make_twiddles() {
+    Twiddles<N> table = {};
+    for (unsigned k = 0; k < N / 2; k++) {
+        const double angle = 2 * PI * k / N;
+        table.cos[k] = to_q15(sin_series(angle + PI / 2));
+        table.sin[k] = to_q15(sin_series(angle));
+    }
+    return table;
+}
+
+}  // namespace fft_detail
+
+/// @brief In-place radix-2 FFT on Q15 data, integer only
+/// @details Decimation in time on separate real and imaginary arrays of N
+/// int16_t each, the only RAM it needs. Every stage halves its outputs, so
+/// nothing can overflow and the result is the DFT divided by N. The
+/// twiddle table is built at compile time and lives in flash: 2 * N bytes.
+/// @tparam N Number of points, power of two
+template <unsigned N>
+class FixedFft {
+    static_assert(N >= 16 && (N & (N - 1)) == 0, "N must be a power of two");
+
+public:
+    static constexpr unsigned SIZE = N;
+
+    /// @brief Forward transform, X[k] = sum(x[n] * e^(-j*2*pi*k*n/N)) / N
+    static void forward(int16_t *re, int16_t *im) {
+        reorder(re, im);
+        for (unsigned half = 1, step = N / 2; half < N; half *= 2, step /= 2) {
+            for (unsigned start = 0; start < N; start += 2 * half) {
+                for (unsigned j = 0; j < half; j++) {
+                    const int32_t c = c_TWIDDLES.cos[j * step];
+                    const int32_t s = c_TWIDDLES.sin[j * step];
+                    const unsigned a = start + j;
+                    const unsigned b = a + half;
+                    // t = x[b] * (c - js)
+                    const int32_t tr = (c * re[b] + s * im[b] + 0x4000) >> 15;
+                    const int32_t ti = (c * im[b] - s * re[b] + 0x4000) >> 15;
+                    const int32_t ar = re[a];
+                    const int32_t ai = im[a];
+                    re[a] = (int16_t)((ar + tr) >> 1);
+                    im[a] = (int16_t)((ai + ti) >> 1);
+                    re[b] = (int16_t)((ar - tr) >> 1);
+                    im[b] = (int16_t)((ai - ti) >> 1);
+                }
+            }
+        }
+    }
+
+    /// @brief Hann window in place, 0.5 - 0.5 * cos(2*pi*n/N)
+    /// @details Coherent gain 1/2: a sine of amplitude A shows as A/4 in
+    /// each of its two bins after forward().
+    static void hann(int16_t *x) {
+        for (unsigned n = 0; n < N; n++) {
+            // cos is symmetric about the half turn, where it is -1
+            const int32_t c = n < N / 2    ? c_TWIDDLES.cos[n]
+                              : n > N / 2 ? c_TWIDDLES.cos[N - n]
+                                          : -32768;
+            const int32_t w = (32768 - c) >> 1;
+            x[n] = (int16_t)((x[n] * w + 0x4000) >> 15);
+        }
+    }
+
+    /// @brief |X[k]|^2
+    static uint32_t power(const int16_t *re, const int16_t *im, unsigned k) {
+        return (uint32_t)((int32_t)re[k] * re[k]) +
+               (uint32_t)((int32_t)im[k] * im[k]);
+    }
+
+private:
+    static void reorder(int16_t *re, int16_t *im) {
+        for (unsigned i = 1, j = 0; i < N; i++) {
+            unsigned bit = N >> 1;
+            for (; j & bit; bit >>= 1) j ^= bit;
+            j |= bit;
+            if (i < j) {
+                int16_t t = re[i];
+                re[i] = re[j];
+                re[j] = t;
+                t = im[i];
+                im[i] = im[j];
+                im[j] = t;
+            }
+        }
+    }
+
+    static constexpr fft_detail::Twiddles<N> c_TWIDDLES =
+        fft_detail::make_twiddles<N>();
+};
@@ -0,0 +1,84 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Noise floor of one channel over a window of samples
+struct NoiseReport {
+    uint32_t rms_q8;   // standard deviation, 1/256 input LSB
+    uint32_t enob_q8;  // effective number of bits, 1/256 bit
+};
+
+/// @brief Noise floor and effective resolution of a steady input
+/// @details Sums and squares Window samples, then reports their standard
+/// deviation and ENOB = Bits - log2(rms * sqrt(12)): an ideal quantiser of
+/// Bits bits has rms = 1 / sqrt(12) LSB. Only meaningful while the input
+/// holds still, eg. during calibration with the ports open. Integer only,
+/// O(1) per sample and one square root and logarithm per window.
+/// @tparam Window Samples per report
+template <unsigned Window>
+class NoiseMeter {
+public:
+    /// @param bits Resolution of the samples, input LSB to full scale
+    explicit constexpr NoiseMeter(unsigned bits) : _bits(bits) {}
+
+    /// @return True when the sample completed a window, see report()
+    bool push(uint16_t x) {
+        _sum += x;
+        _squares += (uint64_t)x * x;
+        if (++_count < Window) return false;
+
+        // Window^2 * variance, exact in 64 bits for 16-bit samples and
+        // windows up to 2^15
+        const uint64_t spread = _squares * Window - _sum * _sum;
+        // rms in 1/256 LSB: sqrt(spread / Window^2 * 2^16)
+        const uint32_t rms_q8 = isqrt(((spread / Window) << 16) / Window);
+        // rms * sqrt(12) in 1/256 LSB; sqrt(12) = 3.4641 = 887 / 256
+        const uint32_t step_q8 = (uint32_t)(((uint64_t)rms_q8 * 887U) >> 8);
+        const int32_t enob_q8 = ((int32_t)_bits << 8) -
+                                (step_q8 ? log2_q8(step_q8) - (8 << 8) : 0);
+        _report = {rms_q8, (uint32_t)(enob_q8 > 0 ? enob_q8 : 0)};
+        _sum = 0;
+        _squares = 0;
+        _count = 0;
+        return true;
+    }
+
+    const NoiseReport &report() const { return _report; }
+
+private:
+    static uint32_t isqrt(uint64_t x) {
+        uint64_t root = 0;
+        for (uint64_t bit = 1ULL << 31; bit; bit >>= 1) {
+            if ((root | bit) * (root | bit) <= x) root |= bit;
+        }
+        return (uint32_t)root;
+    }
+
+    /// @brief log2(x) in 1/256, x > 0
+    static int32_t log2_q8(uint32_t x) {
+        int32_t result = 0;
+        while (x >= 2U << 16) {
+            x >>= 1;
+            result += 256;
+        }
+        while (x < 1U << 16) {
+            x <<= 1;
+            result -= 256;
+        }
+        // x is now in [1, 2) as Q16, square it for every fraction bit
+        for (int32_t bit = 128; bit; bit >>= 1) {
+            x = (uint32_t)(((uint64_t)x * x) >> 16);
+            if (x >= 2U << 16) {
+                x >>= 1;
+                result += bit;
+            }
+        }
+        return result + 16 * 256;
+    }
+
+    unsigned _bits;
+    uint64_t _sum = 0;
+    uint64_t _squares = 0;
+    uint32_t _count = 0;
+    NoiseReport _report = {};
+};
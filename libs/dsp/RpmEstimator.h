@@ -0,0 +1,231 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Engine speed from the intake pulse train of one cylinder
+/// @details One intake pulse per engine cycle, two revolutions. Two
+/// estimators run side by side on every sample:
+///  - Zero crossing: the AC component (a short moving average minus a long
+///    one) goes through a Schmitt trigger whose hysteresis follows the
+///    signal envelope. Rising crossings are interpolated to a 1/256 sample
+///    and their periods averaged over the last PERIODS cycles; a period off
+///    the average by more than a quarter is dropped as a glitch.
+///  - Autocorrelation: the AC component is decimated so the longest period
+///    fits Lags decimated samples and every lag of a running (exponentially
+///    weighted) autocorrelation is updated once per decimated sample, the
+///    work spread evenly over the input samples.
+/// push() is O(1), at most ceil(Lags / decimation) + a few multiplies.
+/// rpm() prefers the zero-crossing average and falls back to the first
+/// autocorrelation peak close to the highest one when the crossings are
+/// missing or jittery, eg. on a noisy signal. It scans the lags, call it at
+/// the block rate.
+/// @tparam Lags Autocorrelation length, sets the resolution at high speed
+template <unsigned Lags = 128>
+class RpmEstimator {
+    static_assert(Lags >= 16, "too few lags");
+
+public:
+    enum class Source : uint8_t { None, ZeroCrossing, Autocorrelation };
+
+    /// @param sample_rate Samples per second of the channel
+    /// @param min_rpm Slowest engine speed to track
+    /// @param max_rpm Fastest engine speed to track
+    RpmEstimator(uint32_t sample_rate, uint32_t min_rpm, uint32_t max_rpm)
+        : _sampleRate(sample_rate),
+          _minPeriod(sample_rate * 120U / max_rpm),
+          _maxPeriod(sample_rate * 120U / min_rpm),
+          _decimation((_maxPeriod + Lags - 1) / Lags),
+          _lagsPerSample((Lags + _decimation - 1) / _decimation) {}
+
+    /// @brief Feed one raw sample
+    void push(uint16_t x) {
+        if (!_primed) {
+            _dc = (int32_t)x << DC_SHIFT;
+            _lp = (int32_t)x << LP_SHIFT;
+            _primed = true;
+        }
+        _dc += x - (_dc >> DC_SHIFT);
+        _lp += x - (_lp >> LP_SHIFT);
+        const int32_t ac = (_lp >> LP_SHIFT) - (_dc >> DC_SHIFT);
+        zeroCrossing(ac);
+        autocorrelation(ac);
+    }
+
+    /// @brief Engine speed, 0 if unknown
+    uint32_t rpm() {
+        uint32_t period_q8 = 0;
+        _source = Source::None;
+        if (crossingsValid()) {
+            period_q8 = _periodSum / PERIODS;
+            _source = Source::ZeroCrossing;
+        } else if ((period_q8 = autocorrelationPeriod()) != 0) {
+            _source = Source::Autocorrelation;
+        }
+        if (!period_q8) return 0;
+        const uint64_t cycle_q8 = (uint64_t)_sampleRate * 120U * 256U;
+        return (uint32_t)((cycle_q8 + period_q8 / 2) / period_q8);
+    }
+
+    /// @brief Which estimator gave the last rpm()
+    Source source() const { return _source; }
+
+private:
+    static constexpr unsigned DC_SHIFT = 11;  // ~2048 samples
+    static constexpr unsigned LP_SHIFT = 2;
+    static constexpr unsigned ENV_SHIFT = 8;
+    static constexpr unsigned ACF_SHIFT = 6;  // decimated samples
+    static constexpr unsigned PERIODS = 8;
+    static constexpr int32_t MIN_HYSTERESIS = 4;  // input units
+
+    void zeroCrossing(int32_t ac) {
+        const int32_t mag = ac < 0 ? -ac : ac;
+        _env += mag - (_env >> ENV_SHIFT);
+        int32_t hysteresis = (_env >> ENV_SHIFT) / 2;
+        if (hysteresis < MIN_HYSTERESIS) hysteresis = MIN_HYSTERESIS;
+
+        if (_since < UINT32_MAX) _since++;
+        if (_since > _maxPeriod) clearPeriods();
+
+        if (ac < -hysteresis) {
+            _low = true;
+        } else if (_low && ac >= 0) {
+            _low = false;
+            // fraction of a sample since the crossing, 0-256
+            const int32_t step = ac - _prevAc;
+            const uint32_t frac = step > 0 ? (uint32_t)((ac << 8) / step) : 0;
+            if (_since <= _maxPeriod) {
+                addPeriod((_since << 8) + _lastFrac - frac);
+            }
+            _since = 0;
+            _lastFrac = frac;
+        }
+        _prevAc = ac;
+    }
+
+    void addPeriod(uint32_t period_q8) {
+        if (period_q8 < (_minPeriod << 8)) return;
+        if (_periods == PERIODS) {
+            const uint32_t mean = _periodSum / PERIODS;
+            if (period_q8 < mean - mean / 4 || period_q8 > mean + mean / 4) {
+                // a few glitches in a row is a new speed
+                if (++_rejects < 3) return;
+                clearPeriods();
+            }
+        }
+        _rejects = 0;
+        if (_periods == PERIODS) {
+            _periodSum -= _period[_next];
+            _jitterSum -= _jitter[_next];
+        } else {
+            _periods++;
+        }
+        const uint32_t mean =
+            _periods > 1 ? (_periodSum + period_q8) / _periods : period_q8;
+        _period[_next] = period_q8;
+        _jitter[_next] = period_q8 > mean ? period_q8 - mean : mean - period_q8;
+        _periodSum += period_q8;
+        _jitterSum += _jitter[_next];
+        _next = (_next + 1) % PERIODS;
+    }
+
+    void clearPeriods() {
+        _periods = 0;
+        _periodSum = 0;
+        _jitterSum = 0;
+        _next = 0;
+        _rejects = 0;
+    }
+
+    // the average is trusted with a full window and a mean deviation
+    // under 1/16 of the period
+    bool crossingsValid() const {
+        return _periods == PERIODS && _jitterSum * 16 < _periodSum;
+    }
+
+    void autocorrelation(int32_t ac) {
+        // finish the lags of the current decimated sample
+        for (unsigned i = 0; i < _lagsPerSample && _lag < Lags; i++, _lag++) {
+            const int32_t other = _history[(_head + Lags - _lag) % Lags];
+            const int32_t product = (_current * other) >> 2;
+            _acf[_lag] += product - (_acf[_lag] >> ACF_SHIFT);
+        }
+        _decSum += ac;
+        if (++_decCount < _decimation) return;
+
+        // next decimated sample, the AC component stays within +-4095
+        _current = _decSum / (int32_t)_decimation;
+        _decSum = 0;
+        _decCount = 0;
+        _head = (_head + 1) % Lags;
+        _history[_head] = _current;
+        if (_filled < Lags) _filled++;
+        _lag = 0;
+    }
+
+    uint32_t autocorrelationPeriod() const {
+        if (_filled < Lags || _acf[0] <= 0) return 0;
+        // skip the zero lag lobe and anything faster than max_rpm
+        unsigned k = 1;
+        while (k < Lags && _acf[k] > 0) k++;
+        if (k * _decimation < _minPeriod) k = _minPeriod / _decimation;
+        if (k < 1) k = 1;
+        const unsigned first = k;
+        int32_t highest = 0;
+        for (; k < Lags - 1; k++) {
+            if (_acf[k] > highest) highest = _acf[k];
+        }
+        // a periodic signal correlates well with itself one period later
+        if (highest < _acf[0] / 4) return 0;
+        // multiples of the period peak about as high, take the first one
+        unsigned best = 0;
+        for (k = first; k < Lags - 1 && !best; k++) {
+            if (_acf[k] >= highest - highest / 4 && _acf[k] >= _acf[k - 1] &&
+                _acf[k] >= _acf[k + 1]) {
+                best = k;
+            }
+        }
+        if (!best) return 0;
+
+        // parabolic interpolation of the peak, in 1/256 lags
+        const int64_t l = _acf[best - 1];
+        const int64_t c = _acf[best];
+        const int64_t r = _acf[best + 1];
+        const int64_t den = l - 2 * c + r;
+        const int64_t offset = den < 0 ? ((l - r) * 128) / den : 0;
+        return (uint32_t)((((int64_t)best << 8) + offset) * _decimation);
+    }
+
+    uint32_t _sampleRate;
+    uint32_t _minPeriod;
+    uint32_t _maxPeriod;
+    uint32_t _decimation;
+    uint32_t _lagsPerSample;
+    Source _source = Source::None;
+    bool _primed = false;
+    int32_t _dc = 0;
+    int32_t _lp = 0;
+
+    // zero crossing
+    int32_t _env = 0;
+    int32_t _prevAc = 0;
+    bool _low = false;
+    uint32_t _since = UINT32_MAX;
+    uint32_t _lastFrac = 0;
+    uint32_t _period[PERIODS] = {};
+    uint32_t _jitter[PERIODS] = {};
+    uint32_t _periodSum = 0;
+    uint32_t _jitterSum = 0;
+    uint8_t _periods = 0;
+    uint8_t _next = 0;
+    uint8_t _rejects = 0;
+
+    // autocorrelation
+    int32_t _history[Lags] = {};
+    int32_t _acf[Lags] = {};
+    int32_t _decSum = 0;
+    uint32_t _decCount = 0;
+    int32_t _current = 0;
+    unsigned _head = 0;
+    unsigned _lag = Lags;
+    unsigned _filled = 0;
+};
@@ -0,0 +1,122 @@
+#pragma once
+
+#include <cstdint>
+
+namespace skew_aligner_detail {
+
+constexpr unsigned FRAC_BITS = 14;
+
+template <unsigned Taps>
+struct Coefficients {
+    int32_t h[Taps];
+    uint32_t abs_sum;  // sum of |h|, bounds the accumulator
+};
+
+/// @brief Lagrange interpolator taps for a delay of delay_q16 / 2^16
+/// samples, compile time only
+template <unsigned Taps>
+constexpr Coefficients<Taps> lagrange(uint32_t delay_q16) {
+    Coefficients<Taps> c = {};
+    const double d = delay_q16 / 65536.0;
+    int32_t sum = 0;
+    unsigned largest = 0;
+    for (unsigned k = 0; k < Taps; k++) {
+        double h = 1;
+        for (unsigned m = 0; m < Taps; m++) {
+            if (m != k) h *= (d - m) / ((double)k - (double)m);
+        }
+        const double scaled = h * (1 << FRAC_BITS);
+        c.h[k] = (int32_t)(scaled + (scaled < 0 ? -0.5 : 0.5));
+        sum += c.h[k];
+        if (c.h[k] > c.h[largest]) largest = k;
+    }
+    // rounding must not change the DC gain
+    c.h[largest] += (1 << FRAC_BITS) - sum;
+    for (unsigned k = 0; k < Taps; k++) {
+        c.abs_sum += (uint32_t)(c.h[k] < 0 ? -c.h[k] : c.h[k]);
+    }
+    return c;
+}
+
+}  // namespace skew_aligner_detail
+
+/// @brief Puts round robin samples of several channels on one time base
+/// @details Channel k is converted k * SkewQ16 / 2^16 samples after
+/// channel 0. Each channel goes through a Lagrange interpolating FIR,
+/// Taps - 1 order polynomial through its last Taps samples, evaluated
+/// 1 + k * SkewQ16 / 2^16 samples back: every output frame is the input
+/// as it was at channel 0's previous conversion. Interpolation is most
+/// accurate with the delay near the middle of the window, eg. 1 to 2 of
+/// the 4-tap window, and exact for channel 0's whole sample. The taps are
+/// computed at compile time, Q14 in flash; Taps multiply-adds per sample
+/// and channel. The history is stored per tap, all channels side by side.
+/// @tparam Taps Window length, 2 (linear) to 6
+/// @tparam Channels Number of channels in a frame
+/// @tparam SkewQ16 Conversion to conversion skew in 1/65536 samples
+template <unsigned Taps, unsigned Channels, uint32_t SkewQ16>
+class SkewAligner {
+    static_assert(Taps >= 2 && Taps <= 6, "2 to 6 taps");
+    static_assert((1U << 16) + (Channels - 1) * SkewQ16 <= (Taps - 1) << 16,
+                  "delay outside the window");
+
+    struct Table {
+        skew_aligner_detail::Coefficients<Taps> channel[Channels];
+    };
+
+    static constexpr Table make_table() {
+        Table table = {};
+        for (unsigned ch = 0; ch < Channels; ch++) {
+            table.channel[ch] = skew_aligner_detail::lagrange<Taps>(
+                (1U << 16) + ch * SkewQ16);
+        }
+        return table;
+    }
+
+    static constexpr Table TABLE = make_table();
+
+    static constexpr bool fits_accumulator() {
+        for (unsigned ch = 0; ch < Channels; ch++) {
+            if ((uint64_t)TABLE.channel[ch].abs_sum * 65535U >= (1ULL << 31)) {
+                return false;
+            }
+        }
+        return true;
+    }
+    static_assert(fits_accumulator(), "accumulator overflows for 16-bit input");
+
+public:
+    /// @brief Feed one frame, in and out may be the same array
+    /// @param in Samples of channels 0 to Channels - 1, in conversion order
+    /// @param out Simultaneous values, one channel 0 sample late
+    void push(const uint16_t *in, uint16_t *out) {
+        if (!_primed) {
+            // start as if the input had always been the first frame
+            for (unsigned k = 0; k < Taps; k++) {
+                for (unsigned ch = 0; ch < Channels; ch++) {
+                    _history[k][ch] = in[ch];
+                }
+            }
+            _primed = true;
+        }
+        for (unsigned k = Taps - 1; k > 0; k--) {
+            for (unsigned ch = 0; ch < Channels; ch++) {
+                _history[k][ch] = _history[k - 1][ch];
+            }
+        }
+        for (unsigned ch = 0; ch < Channels; ch++) _history[0][ch] = in[ch];
+
+        for (unsigned ch = 0; ch < Channels; ch++) {
+            const int32_t *h = TABLE.channel[ch].h;
+            int32_t acc = 1 << (skew_aligner_detail::FRAC_BITS - 1);
+            for (unsigned k = 0; k < Taps; k++) {
+                acc += h[k] * (int32_t)_history[k][ch];
+            }
+            acc >>= skew_aligner_detail::FRAC_BITS;
+            out[ch] = (uint16_t)(acc < 0 ? 0 : acc > 65535 ? 65535 : acc);
+        }
+    }
+
+private:
+    uint16_t _history[Taps][Channels] = {};  // newest first
+    bool _primed = false;
+};
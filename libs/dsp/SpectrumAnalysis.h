@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FixedFft.h"
+
+/// @brief Harmonic content of a pulse train, from a Hann-windowed FFT
+struct SpectrumReport {
+    static constexpr unsigned HARMONICS = 5;
+
+    uint32_t fundamental_q8;  // bin of the fundamental, 1/256 bins
+    /// Peak amplitude of the fundamental and its harmonics, in input units
+    uint16_t amplitude[HARMONICS];
+    /// Share of the energy at fractional orders of the fundamental, 1/1000
+    uint16_t subharmonic_permille;
+};
+
+/// @brief Analyse a captured window of N samples
+/// @details Works in place on the capture: the mean is removed, the rest
+/// Hann windowed and transformed, so re[] has to hold the samples and im[]
+/// may hold anything. Inputs are at most 4095 from their mean, eg. raw
+/// 12-bit counts, and get scaled up to use the Q15 range.
+///
+/// The fundamental is the firing frequency when it is known, else the
+/// strongest bin. Each harmonic's amplitude comes from the energy of the
+/// Hann main lobe (+-2 bins) around its nearest peak. With the firing
+/// frequency as fundamental and orders = number of cylinders, every
+/// multiple of fundamental / orders which is not a harmonic only gets
+/// energy when the cylinders do not pull alike; that energy over the total
+/// is the sub-harmonic share.
+/// @param fundamental_q8 Expected fundamental, 1/256 bins, 0 if unknown
+/// @param orders Fractional orders per harmonic, 1 disables them
+template <unsigned N>
+SpectrumReport analyze_spectrum(int16_t *re, int16_t *im,
+                                uint32_t fundamental_q8, unsigned orders) {
+    typedef FixedFft<N> Fft;
+    // 12-bit input scaled by 8 stays within Q15
+    constexpr unsigned INPUT_SHIFT = 3;
+    // the window spreads a sine over +-2 bins
+    constexpr unsigned LOBE = 2;
+
+    int32_t sum = 0;
+    for (unsigned n = 0; n < N; n++) sum += re[n];
+    const int32_t mean = sum / (int32_t)N;
+    for (unsigned n = 0; n < N; n++) {
+        re[n] = (int16_t)((re[n] - mean) << INPUT_SHIFT);
+        im[n] = 0;
+    }
+    Fft::hann(re);
+    Fft::forward(re, im);
+
+    auto lobe = [&](unsigned k) {
+        uint32_t energy = 0;
+        for (unsigned i = k - LOBE; i <= k + LOBE; i++) {
+            energy += Fft::power(re, im, i);
+        }
+        return energy;
+    };
+    auto peak_near = [&](uint32_t centre_q8) {
+        unsigned k = (centre_q8 + 128) >> 8;
+        unsigned best = k;
+        for (unsigned i = k - 1; i <= k + 1; i++) {
+            if (Fft::power(re, im, i) > Fft::power(re, im, best)) best = i;
+        }
+        return best;
+    };
+
+    SpectrumReport report = {};
+    // skip what is left of DC under the window
+    if (!fundamental_q8) {
+        unsigned best = LOBE + 1;
+        for (unsigned k = LOBE + 1; k < N / 2 - LOBE; k++) {
+            if (Fft::power(re, im, k) > Fft::power(re, im, best)) best = k;
+        }
+        fundamental_q8 = best << 8;
+    }
+    if (fundamental_q8 < ((LOBE + 2) << 8) ||
+        fundamental_q8 >= ((N / 2 - LOBE - 1) << 8)) {
+        return report;
+    }
+
+    // parabolic interpolation of the fundamental's peak
+    const unsigned k0 = peak_near(fundamental_q8);
+    const int64_t l = Fft::power(re, im, k0 - 1);
+    const int64_t c = Fft::power(re, im, k0);
+    const int64_t r = Fft::power(re, im, k0 + 1);
+    const int64_t den = l - 2 * c + r;
+    report.fundamental_q8 =
+        (k0 << 8) + (den < 0 ? (int32_t)(((l - r) * 128) / den) : 0);
+
+    // energy of a sine of amplitude A in one half of the spectrum, after
+    // the 1/N of forward() and the Hann window: A^2 * 3 / 32
+    auto amplitude = [](uint32_t energy) {
+        const uint64_t square = (uint64_t)energy * 32 / 3;
+        uint32_t root = 0;
+        for (uint32_t bit = 1U << 17; bit; bit >>= 1) {
+            const uint64_t trial = root | bit;
+            if (trial * trial <= square) root |= bit;
+        }
+        return (uint16_t)(root >> INPUT_SHIFT);
+    };
+
+    uint64_t harmonic = 0;
+    uint64_t fractional = 0;
+    if (orders < 1) orders = 1;
+    const uint32_t step_q8 = report.fundamental_q8 / orders;
+    if (!step_q8) return report;
+    for (unsigned m = 1;; m++) {
+        const uint32_t centre_q8 = step_q8 * m;
+        if (centre_q8 >= ((N / 2 - LOBE - 1) << 8)) break;
+        if (centre_q8 < ((LOBE + 1) << 8)) continue;
+        const uint32_t energy = lobe(peak_near(centre_q8));
+        if (m % orders) {
+            fractional += energy;
+            continue;
+        }
+        harmonic += energy;
+        if (m / orders <= SpectrumReport::HARMONICS) {
+            report.amplitude[m / orders - 1] = amplitude(energy);
+        }
+    }
+    if (harmonic + fractional) {
+        report.subharmonic_permille =
+            (uint16_t)(fractional * 1000 / (harmonic + fractional));
+    }
+    return report;
+}
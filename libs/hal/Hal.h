@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#ifndef VACUUM_HOST
+#include "pico/time.h"
+#endif
+
+/// @brief Thin hardware layer of the application and its libraries.
+/// @details Clock, timer, GPIO, I2C and single-shot ADC, the parts of the
+/// Pico SDK used outside of the DMA paths (AdcDmaHal, LcdTxQueue). The Pico
+/// backend is inline and compiles down to the SDK calls. The host backend
+/// (VACUUM_HOST) runs everything on a simulated clock which only moves when
+/// the firmware waits, so it runs as fast as the host can execute the code;
+/// see HalHost.h for its controls.
+namespace hal {
+
+/// @brief Timer callback, return false to stop repeating
+typedef bool (*TimerCallback)(void *context);
+
+/// @brief Storage of one repeating timer, owned by the caller
+struct RepeatingTimer {
+    TimerCallback callback;
+    void *context;
+#ifdef VACUUM_HOST
+    uint64_t period_us;
+#else
+    repeating_timer_t timer;
+#endif
+};
+
+/// @brief Bring up stdio
+void init();
+
+/// @brief Microseconds since boot
+uint64_t time_us();
+
+/// @brief Milliseconds since boot, wraps after 49 days
+uint32_t millis();
+
+void sleep_us(uint64_t us);
+void sleep_ms(uint32_t ms);
+
+/// @brief Nothing to do until the next interrupt
+/// @details Called by busy loops, on the host it advances the clock to the
+/// next timer or DMA event.
+void idle();
+
+/// @brief False once the host run has reached its end, always true on target
+bool running();
+
+/// @brief Call callback every period_ms from interrupt context
+/// @param period_ms Negative counts from the start of the previous call, as
+/// in the SDK
+/// @return False if no timer slot is available
+bool add_repeating_timer_ms(int32_t period_ms, TimerCallback callback,
+                            void *context, RepeatingTimer *timer);
+
+bool cancel_repeating_timer(RepeatingTimer *timer);
+
+/// @brief Configure pin as input
+void gpio_input(unsigned pin, bool pull_up);
+
+bool gpio_read(unsigned pin);
+
+/// @brief Levels of all GPIOs, bit n is GPIOn
+uint32_t gpio_read_all();
+
+/// @brief Set up the default I2C instance on its default pins
+void i2c_setup(uint32_t baudrate);
+
+/// @brief Blocking write on the default I2C instance
+/// @return Number of bytes written, negative if the address was not
+/// acknowledged
+int i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop);
+
+/// @brief Blocking read on the default I2C instance
+/// @return Number of bytes read, negative if the address was not
+/// acknowledged
+int i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop);
+
+/// @brief Power up the ADC
+void adc_setup();
+
+/// @brief Single conversion of given ADC input, raw 12-bit counts
+uint16_t adc_read(unsigned input);
+
+}  // namespace hal
+
+#ifndef VACUUM_HOST
+#include "HalPico.h"
+#endif
@@ -0,0 +1,231 @@
+#include "HalHost.h"
+
+#include <chrono>
+#include <cstdio>
+#include <thread>
+
+#include "Hal.h"
+
+namespace hal {
+
+namespace {
+
+constexpr size_t MAX_EVENTS = 16;
+constexpr uint16_t ADC_MID_SCALE = 2048U;
+constexpr uint64_t IDLE_STEP_US = 1000U;
+// start, address byte and stop of every transfer, 9 bits per byte
+constexpr uint32_t I2C_FRAME_BITS = 11U;
+constexpr uint32_t I2C_BYTE_BITS = 9U;
+
+struct Event {
+    uint64_t due_us;
+    host::EventHandler handler;
+    void *context;
+};
+
+// Plain constant-initialised state: global constructors (Encoder, LCD)
+// already use the clock and GPIOs before main()
+uint64_t s_now_us = 0;
+uint64_t s_end_us = 0;
+unsigned s_speed = 0;
+Event s_events[MAX_EVENTS] = {};
+uint32_t s_gpio = 0;
+uint32_t s_i2c_bit_ns = 10000U;  // 100 kHz until set up
+host::I2cDevice *s_i2c[128] = {};
+host::AnalogSource s_source = nullptr;
+void *s_source_context = nullptr;
+
+Event *next_event() {
+    Event *next = nullptr;
+    for (Event &event : s_events) {
+        if (event.handler && (!next || event.due_us < next->due_us)) {
+            next = &event;
+        }
+    }
+    return next;
+}
+
+void pace(uint64_t from_us, uint64_t to_us) {
+    using namespace std::chrono;
+    static steady_clock::time_point s_wall;
+    static uint64_t s_wall_us = 0;
+    if (!s_speed) return;
+    if (s_wall_us == 0 || from_us < s_wall_us) {
+        s_wall = steady_clock::now();
+        s_wall_us = from_us;
+    }
+    std::this_thread::sleep_until(
+        s_wall + microseconds((to_us - s_wall_us) / s_speed));
+}
+
+uint64_t timer_event(void *context, uint64_t due_us) {
+    RepeatingTimer *timer = static_cast<RepeatingTimer *>(context);
+    if (!timer->callback(timer->context)) return 0;
+    return due_us + timer->period_us;
+}
+
+// Runs the transfer on the device, returns its bus time in us
+uint64_t i2c_transfer_at(uint8_t addr, size_t len, bool read, uint8_t *data,
+                         uint64_t start_us, bool &ack) {
+    const uint32_t byte_ns = I2C_BYTE_BITS * s_i2c_bit_ns;
+    host::I2cDevice *device = s_i2c[addr & 0x7F];
+    ack = false;
+    if (device) {
+        ack = read ? device->read(data, len, start_us, byte_ns)
+                   : device->write(data, len, start_us, byte_ns);
+    }
+    // a NACKed address ends the transfer after the first byte
+    const uint64_t bits = I2C_FRAME_BITS + (ack ? len * I2C_BYTE_BITS : 0);
+    return (bits * s_i2c_bit_ns + 999U) / 1000U;
+}
+
+int i2c_transfer(uint8_t addr, size_t len, bool read, uint8_t *data) {
+    bool ack;
+    host::advance(i2c_transfer_at(addr, len, read, data, s_now_us, ack));
+    return ack ? (int)len : -1;
+}
+
+}  // namespace
+
+void init() { setvbuf(stdout, nullptr, _IOLBF, 0); }
+
+uint64_t time_us() { return s_now_us; }
+
+uint32_t millis() { return (uint32_t)(s_now_us / 1000U); }
+
+void sleep_us(uint64_t us) { host::advance(us); }
+
+void sleep_ms(uint32_t ms) { host::advance((uint64_t)ms * 1000U); }
+
+void idle() {
+    const Event *next = next_event();
+    if (next && next->due_us > s_now_us) {
+        host::advance_to(next->due_us);
+    } else if (next) {
+        host::advance_to(s_now_us);
+    } else {
+        host::advance(IDLE_STEP_US);
+    }
+}
+
+bool running() { return !s_end_us || s_now_us < s_end_us; }
+
+bool add_repeating_timer_ms(int32_t period_ms, TimerCallback callback,
+                            void *context, RepeatingTimer *timer) {
+    timer->callback = callback;
+    timer->context = context;
+    timer->period_us = (uint64_t)(period_ms < 0 ? -period_ms : period_ms) *
+                       1000U;
+    return host::schedule(s_now_us + timer->period_us, timer_event, timer);
+}
+
+bool cancel_repeating_timer(RepeatingTimer *timer) {
+    host::unschedule(timer_event, timer);
+    return true;
+}
+
+void gpio_input(unsigned pin, bool pull_up) {
+    if (pull_up) s_gpio |= 1U << pin;
+}
+
+bool gpio_read(unsigned pin) { return s_gpio & (1U << pin); }
+
+uint32_t gpio_read_all() { return s_gpio; }
+
+void i2c_setup(uint32_t baudrate) {
+    s_i2c_bit_ns = (1000000000U + baudrate - 1U) / baudrate;
+}
+
+int i2c_write(uint8_t addr, const uint8_t *src, size_t len, bool nostop) {
+    return i2c_transfer(addr, len, false, const_cast<uint8_t *>(src));
+}
+
+int i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    return i2c_transfer(addr, len, true, dst);
+}
+
+void adc_setup() {}
+
+uint16_t adc_read(unsigned input) {
+    // one conversion takes 96 ADC clocks at 48 MHz
+    host::advance(2);
+    return host::analog_sample(input, s_now_us);
+}
+
+namespace host {
+
+void set_analog_source(AnalogSource source, void *context) {
+    s_source = source;
+    s_source_context = context;
+}
+
+uint16_t analog_sample(unsigned input, uint64_t t_us) {
+    if (!s_source) return ADC_MID_SCALE;
+    return s_source(input, t_us, s_source_context) & 0x0FFFU;
+}
+
+void gpio_set(unsigned pin, bool level) {
+    if (level) {
+        s_gpio |= 1U << pin;
+    } else {
+        s_gpio &= ~(1U << pin);
+    }
+}
+
+void attach_i2c(uint8_t addr, I2cDevice *device) { s_i2c[addr & 0x7F] = device; }
+
+uint64_t i2c_write_background(uint8_t addr, const uint8_t *src, size_t len) {
+    bool ack;
+    return s_now_us + i2c_transfer_at(addr, len, false,
+                                      const_cast<uint8_t *>(src), s_now_us,
+                                      ack);
+}
+
+bool schedule(uint64_t due_us, EventHandler handler, void *context) {
+    for (Event &event : s_events) {
+        if (!event.handler) {
+            event = {due_us, handler, context};
+            return true;
+        }
+    }
+    return false;
+}
+
+void unschedule(EventHandler handler, void *context) {
+    for (Event &event : s_events) {
+        if (event.handler == handler && event.context == context) {
+            event.handler = nullptr;
+        }
+    }
+}
+
+void advance_to(uint64_t t_us) {
+    Event *event;
+    while ((event = next_event()) != nullptr && event->due_us <= t_us) {
+        const uint64_t due_us = event->due_us;
+        const EventHandler handler = event->handler;
+        void *const context = event->context;
+        // the handler may reschedule or cancel itself or others
+        event->handler = nullptr;
+        if (due_us > s_now_us) {
+            pace(s_now_us, due_us);
+            s_now_us = due_us;
+        }
+        const uint64_t next_us = handler(context, due_us);
+        if (next_us) schedule(next_us, handler, context);
+    }
+    if (t_us > s_now_us) {
+        pace(s_now_us, t_us);
+        s_now_us = t_us;
+    }
+}
+
+void advance(uint64_t us) { advance_to(s_now_us + us); }
+
+void set_end_time(uint64_t t_us) { s_end_us = t_us; }
+
+void set_speed(unsigned factor) { s_speed = factor; }
+
+}  // namespace host
+
+}  // namespace hal
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Hal.h"
+
+/// @brief Host-only controls of the simulated hardware.
+/// @details The simulated clock starts at 0 and moves only when the firmware
+/// waits: sleeps, hal::idle() and I2C transfers (by their bus time). Timer
+/// callbacks and DMA completions are events on this clock and run in order
+/// as it passes them, which is where interrupts would have been taken.
+namespace hal {
+namespace host {
+
+/// @brief Returns raw 12-bit ADC counts of given input at given time
+typedef uint16_t (*AnalogSource)(unsigned input, uint64_t t_us,
+                                 void *context);
+
+/// @brief Set the signal feeding the simulated ADC inputs
+/// @param source Source function, nullptr gives a mid-scale constant
+void set_analog_source(AnalogSource source, void *context);
+
+/// @brief Sample the analog source, used by the ADC and ADC DMA stand-ins
+uint16_t analog_sample(unsigned input, uint64_t t_us);
+
+/// @brief Drive an input pin, eg. encoder or button contacts
+void gpio_set(unsigned pin, bool level);
+
+/// @brief Simulated I2C target on the default bus
+class I2cDevice {
+public:
+    virtual ~I2cDevice() = default;
+
+    /// @param start_us Time of the start condition
+    /// @param byte_ns Bus time of one byte, the address byte included
+    /// @return False to NACK the address
+    virtual bool write(const uint8_t *src, size_t len, uint64_t start_us,
+                       uint32_t byte_ns) = 0;
+
+    virtual bool read(uint8_t *dst, size_t len, uint64_t start_us,
+                      uint32_t byte_ns) = 0;
+};
+
+/// @brief Put device on the bus at given 7-bit address, nullptr removes it
+void attach_i2c(uint8_t addr, I2cDevice *device);
+
+/// @brief Write transaction of a DMA-fed controller, eg. from an event
+/// @details Starts now like hal::i2c_write(), but leaves the clock alone:
+/// the CPU is not held up while the bytes are on the bus. A NACK is not
+/// reported, the Pico's TX abort is cleared and ignored the same way.
+/// @return Time the stop condition has left the bus
+uint64_t i2c_write_background(uint8_t addr, const uint8_t *src, size_t len);
+
+/// @brief Event on the simulated clock
+/// @return Time of the next run, 0 to drop the event
+typedef uint64_t (*EventHandler)(void *context, uint64_t due_us);
+
+/// @return False if the event table is full
+bool schedule(uint64_t due_us, EventHandler handler, void *context);
+
+void unschedule(EventHandler handler, void *context);
+
+/// @brief Move the clock forward, running every event which falls due
+void advance_to(uint64_t t_us);
+
+void advance(uint64_t us);
+
+/// @brief Make hal::running() return false from t_us on, 0 runs forever
+void set_end_time(uint64_t t_us);
+
+/// @brief Pace the simulated clock against the wall clock
+/// @param factor 0 (default) runs as fast as possible, N runs N times
+/// faster than real time
+void set_speed(unsigned factor);
+
+}  // namespace host
+}  // namespace hal
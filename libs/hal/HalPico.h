@@ -0,0 +1,83 @@
+#pragma once
+
+// Pico SDK backend of Hal.h, included from there
+
+#include "hardware/adc.h"
+#include "hardware/gpio.h"
+#include "hardware/i2c.h"
+#include "pico/binary_info.h"
+#include "pico/stdlib.h"
+
+namespace hal {
+
+inline void init() { stdio_init_all(); }
+
+inline uint64_t time_us() { return time_us_64(); }
+
+inline uint32_t millis() { return to_ms_since_boot(get_absolute_time()); }
+
+inline void sleep_us(uint64_t us) { ::sleep_us(us); }
+
+inline void sleep_ms(uint32_t ms) { ::sleep_ms(ms); }
+
+inline void idle() { tight_loop_contents(); }
+
+inline bool running() { return true; }
+
+namespace detail {
+inline bool timer_trampoline(repeating_timer_t *rt) {
+    RepeatingTimer *timer = static_cast<RepeatingTimer *>(rt->user_data);
+    return timer->callback(timer->context);
+}
+}  // namespace detail
+
+inline bool add_repeating_timer_ms(int32_t period_ms, TimerCallback callback,
+                                   void *context, RepeatingTimer *timer) {
+    timer->callback = callback;
+    timer->context = context;
+    return ::add_repeating_timer_ms(period_ms, detail::timer_trampoline, timer,
+                                    &timer->timer);
+}
+
+inline bool cancel_repeating_timer(RepeatingTimer *timer) {
+    return ::cancel_repeating_timer(&timer->timer);
+}
+
+inline void gpio_input(unsigned pin, bool pull_up) {
+    gpio_init(pin);
+    gpio_set_dir(pin, GPIO_IN);
+    if (pull_up) gpio_pull_up(pin);
+}
+
+inline bool gpio_read(unsigned pin) { return gpio_get(pin); }
+
+inline uint32_t gpio_read_all() { return gpio_get_all(); }
+
+inline void i2c_setup(uint32_t baudrate) {
+    i2c_init(i2c_default, baudrate);
+    gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
+    gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
+    gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
+    gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
+    // Make the I2C pins available to picotool
+    bi_decl(bi_2pins_with_func(PICO_DEFAULT_I2C_SDA_PIN,
+                               PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C));
+}
+
+inline int i2c_write(uint8_t addr, const uint8_t *src, size_t len,
+                     bool nostop) {
+    return i2c_write_blocking(i2c_default, addr, src, len, nostop);
+}
+
+inline int i2c_read(uint8_t addr, uint8_t *dst, size_t len, bool nostop) {
+    return i2c_read_blocking(i2c_default, addr, dst, len, nostop);
+}
+
+inline void adc_setup() { adc_init(); }
+
+inline uint16_t adc_read(unsigned input) {
+    adc_select_input(input);
+    return ::adc_read();
+}
+
+}  // namespace hal
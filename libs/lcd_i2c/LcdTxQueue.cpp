@@ -0,0 +1,150 @@
+#include "LcdTxQueue.h"
+
+#include "hardware/dma.h"
+#include "hardware/i2c.h"
+#include "hardware/irq.h"
+#include "hardware/sync.h"
+#include "hardware/timer.h"
+#include "pico/stdlib.h"
+
+static constexpr uint16_t WORD_MASK = LCD_TX_QUEUE_WORDS - 1;
+static constexpr uint8_t SEGMENT_MASK = LCD_TX_QUEUE_SEGMENTS - 1;
+static constexpr uint RING_BITS =
+    __builtin_ctz(LCD_TX_QUEUE_WORDS * sizeof(uint32_t));
+
+static_assert((LCD_TX_QUEUE_WORDS & WORD_MASK) == 0,
+              "LCD_TX_QUEUE_WORDS must be a power of two");
+static_assert((LCD_TX_QUEUE_SEGMENTS & SEGMENT_MASK) == 0 &&
+                  LCD_TX_QUEUE_SEGMENTS <= 128,
+              "LCD_TX_QUEUE_SEGMENTS must be a power of two up to 128");
+
+LcdTxQueue *LcdTxQueue::_instance = nullptr;
+
+bool LcdTxQueue::begin(uint8_t address, uint32_t baudrate) {
+    i2c_inst_t *const i2c = i2c_default;
+    if (_instance) return _instance == this;
+    _dma = dma_claim_unused_channel(false);
+    _alarm = hardware_alarm_claim_unused(false);
+    if (_dma < 0 || _alarm < 0) return false;
+    _i2c = i2c;
+    _address = address;
+    _instance = this;
+    // start + 8 data bits + ack per byte, rounded up
+    _byteUs = (9U * 1000000U + baudrate - 1) / baudrate;
+
+    // The target address is latched once, the LCD is alone on this bus
+    i2c->hw->enable = 0;
+    i2c->hw->tar = address;
+    i2c->hw->enable = 1;
+
+    dma_channel_config cfg = dma_channel_get_default_config(_dma);
+    channel_config_set_transfer_data_size(&cfg, DMA_SIZE_32);
+    channel_config_set_read_increment(&cfg, true);
+    channel_config_set_write_increment(&cfg, false);
+    channel_config_set_ring(&cfg, false, RING_BITS);
+    channel_config_set_dreq(&cfg, i2c_get_dreq(i2c, true));
+    dma_channel_configure(_dma, &cfg, &i2c->hw->data_cmd, _words, 0, false);
+
+    dma_channel_set_irq1_enabled(_dma, true);
+    irq_add_shared_handler(DMA_IRQ_1, dmaIrq,
+                           PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_1, true);
+    hardware_alarm_set_callback(_alarm, alarmIrq);
+    return true;
+}
+
+bool LcdTxQueue::push(const uint8_t *data, size_t size, uint32_t settle_us) {
+    if (!size) return true;
+    const uint16_t head = _wordHead;
+    const uint16_t used = head - _wordTail;
+    if (size > (size_t)(LCD_TX_QUEUE_WORDS - used) ||
+        (uint8_t)(_segHead - _segTail) >= LCD_TX_QUEUE_SEGMENTS) {
+        _overruns++;
+        if (_overrun) _overrun(_overrunContext);
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        _words[(head + i) & WORD_MASK] = data[i];
+    }
+    _words[(head + size - 1) & WORD_MASK] |= I2C_IC_DATA_CMD_STOP_BITS;
+
+    Segment &segment = _segments[_segHead & SEGMENT_MASK];
+    segment.start = head & WORD_MASK;
+    segment.size = size;
+    segment.settle_us = settle_us;
+    _wordHead = head + size;
+    if (used + size > _maxDepth) _maxDepth = used + size;
+
+    const uint32_t irq = save_and_disable_interrupts();
+    _segHead = _segHead + 1;
+    kick();
+    restore_interrupts(irq);
+    return true;
+}
+
+void LcdTxQueue::drain() const {
+    while (!idle()) tight_loop_contents();
+}
+
+void LcdTxQueue::setCompletionHandler(Callback f, void *context) {
+    _completion = f;
+    _completionContext = context;
+}
+
+void LcdTxQueue::setOverrunHandler(Callback f, void *context) {
+    _overrun = f;
+    _overrunContext = context;
+}
+
+LcdTxQueue::Stats LcdTxQueue::stats() const {
+    return {(uint16_t)(_wordHead - _wordTail), _maxDepth, _transfers,
+            _overruns};
+}
+
+// Interrupts disabled or IRQ context
+void LcdTxQueue::kick() {
+    if (_busy || _segHead == _segTail) return;
+    const Segment &segment = _segments[_segTail & SEGMENT_MASK];
+    _busy = true;
+    dma_channel_set_read_addr(_dma, &_words[segment.start], false);
+    dma_channel_set_trans_count(_dma, segment.size, true);
+}
+
+void LcdTxQueue::onDmaDone() {
+    const Segment &segment = _segments[_segTail & SEGMENT_MASK];
+    const uint32_t settle_us = segment.settle_us;
+    _wordTail = _wordTail + segment.size;
+    _segTail = _segTail + 1;
+    _transfers++;
+
+    // A NACK flushes the TX FIFO and holds it until the abort is cleared
+    if (_i2c->hw->raw_intr_stat & I2C_IC_RAW_INTR_STAT_TX_ABRT_BITS) {
+        (void)_i2c->hw->clr_tx_abrt;
+    }
+
+    if (settle_us) {
+        // The DMA is done when the last word enters the FIFO, not the bus
+        const uint32_t delay_us = (_i2c->hw->txflr + 1) * _byteUs + settle_us;
+        if (!hardware_alarm_set_target(_alarm,
+                                       make_timeout_time_us(delay_us))) {
+            return;
+        }
+    }
+    onSettled();
+}
+
+void LcdTxQueue::onSettled() {
+    _busy = false;
+    kick();
+    if (idle() && _completion) _completion(_completionContext);
+}
+
+void LcdTxQueue::dmaIrq() {
+    if (_instance && dma_channel_get_irq1_status(_instance->_dma)) {
+        dma_channel_acknowledge_irq1(_instance->_dma);
+        _instance->onDmaDone();
+    }
+}
+
+void LcdTxQueue::alarmIrq(unsigned alarm) { _instance->onSettled(); }
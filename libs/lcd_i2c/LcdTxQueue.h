@@ -0,0 +1,105 @@
+#pragma once
+
+#include <inttypes.h>
+#include <stddef.h>
+
+struct i2c_inst;
+
+// I2C words (IC_DATA_CMD values) in the ring, power of two
+#define LCD_TX_QUEUE_WORDS 512
+// queued transfers, power of two
+#define LCD_TX_QUEUE_SEGMENTS 16
+
+/// @brief Non-blocking I2C transmit queue drained by DMA
+/// @details Every push() is one I2C write transaction with an optional
+/// settle time. The DMA feeds the I2C TX FIFO straight from the ring (DMA
+/// read ring wrap), and a hardware alarm holds off the next transaction
+/// until the FIFO has drained and the settle time has passed, eg. the
+/// 1.52 ms of an HD44780 clear. push() never waits: when the ring is full
+/// the transfer is dropped and counted as an overrun.
+/// Producer calls must come from one core, the one which called begin().
+/// On the host build the transfers go to the simulated I2C bus as events
+/// on the simulated clock, with the same ring, settle times and overruns.
+class LcdTxQueue {
+public:
+    typedef void (*Callback)(void *context);
+
+    struct Stats {
+        uint16_t depth;     // words waiting or in flight
+        uint16_t maxDepth;  // high-water mark of depth
+        uint32_t transfers;
+        uint32_t overruns;
+    };
+
+    /// @brief Claim DMA channel and hardware alarm, set I2C target address
+    /// @details Uses the default I2C instance, already set up by the driver
+    /// @return False if there is no free DMA channel or alarm
+    bool begin(uint8_t address, uint32_t baudrate);
+
+    /// @brief Queue one write transaction
+    /// @param data Bytes to write
+    /// @param size Number of bytes
+    /// @param settle_us Idle time after the last byte has left the bus
+    /// @return False on overrun, nothing has been queued
+    bool push(const uint8_t *data, size_t size, uint32_t settle_us = 0);
+
+    /// @brief True when nothing is queued or in flight
+    bool idle() const { return !_busy && _segHead == _segTail; }
+
+    /// @brief Block until everything has been sent
+    void drain() const;
+
+    /// @brief Called from IRQ context when the queue runs empty
+    void setCompletionHandler(Callback f, void *context);
+
+    /// @brief Called from push() when a transfer had to be dropped
+    void setOverrunHandler(Callback f, void *context);
+
+    Stats stats() const;
+
+#ifdef VACUUM_HOST
+    /// @brief Host only: while set, every push() overruns as if the ring
+    /// were full
+    void setForcedFull(bool full) { _forcedFull = full; }
+#endif
+
+private:
+    struct Segment {
+        uint16_t start;
+        uint16_t size;
+        uint32_t settle_us;
+    };
+
+    static void dmaIrq();
+    static void alarmIrq(unsigned alarm);
+    void kick();
+    void onDmaDone();
+    void onSettled();
+
+    static LcdTxQueue *_instance;
+
+    struct i2c_inst *_i2c = nullptr;
+    uint8_t _address = 0;
+    int _dma = -1;
+    int _alarm = -1;
+    uint32_t _byteUs = 0;
+    volatile bool _busy = false;
+    volatile uint16_t _wordHead = 0;
+    volatile uint16_t _wordTail = 0;
+    volatile uint8_t _segHead = 0;
+    volatile uint8_t _segTail = 0;
+    Segment _segments[LCD_TX_QUEUE_SEGMENTS];
+    uint16_t _maxDepth = 0;
+    uint32_t _transfers = 0;
+    uint32_t _overruns = 0;
+    Callback _completion = nullptr;
+    void *_completionContext = nullptr;
+    Callback _overrun = nullptr;
+    void *_overrunContext = nullptr;
+#ifdef VACUUM_HOST
+    bool _forcedFull = false;
+#endif
+    // DMA read ring wraps on the buffer size, so it must be aligned to it
+    uint32_t _words[LCD_TX_QUEUE_WORDS]
+        __attribute__((aligned(LCD_TX_QUEUE_WORDS * sizeof(uint32_t))));
+};
@@ -0,0 +1,121 @@
+#include "LcdTxQueue.h"
+
+#include "Hal.h"
+#include "HalHost.h"
+
+// The DMA and the settle alarm are events on the simulated clock. A
+// transfer goes onto the simulated bus as soon as it is at the head of the
+// queue, the DMA completes once its stop condition has left the bus and
+// the settle time runs from there. The events run wherever the main loop
+// waits, as the interrupts would.
+
+static constexpr uint16_t WORD_MASK = LCD_TX_QUEUE_WORDS - 1;
+static constexpr uint8_t SEGMENT_MASK = LCD_TX_QUEUE_SEGMENTS - 1;
+
+LcdTxQueue *LcdTxQueue::_instance = nullptr;
+
+bool LcdTxQueue::begin(uint8_t address, uint32_t baudrate) {
+    if (_instance) return _instance == this;
+    _address = address;
+    _instance = this;
+    // start + 8 data bits + ack per byte, rounded up
+    _byteUs = (9U * 1000000U + baudrate - 1) / baudrate;
+    return true;
+}
+
+bool LcdTxQueue::push(const uint8_t *data, size_t size, uint32_t settle_us) {
+    if (!size) return true;
+    const uint16_t head = _wordHead;
+    const uint16_t used = head - _wordTail;
+    if (_forcedFull || size > (size_t)(LCD_TX_QUEUE_WORDS - used) ||
+        (uint8_t)(_segHead - _segTail) >= LCD_TX_QUEUE_SEGMENTS) {
+        _overruns++;
+        if (_overrun) _overrun(_overrunContext);
+        return false;
+    }
+
+    for (size_t i = 0; i < size; i++) {
+        _words[(head + i) & WORD_MASK] = data[i];
+    }
+
+    Segment &segment = _segments[_segHead & SEGMENT_MASK];
+    segment.start = head & WORD_MASK;
+    segment.size = size;
+    segment.settle_us = settle_us;
+    _wordHead = head + size;
+    if (used + size > _maxDepth) _maxDepth = used + size;
+
+    _segHead = _segHead + 1;
+    kick();
+    return true;
+}
+
+void LcdTxQueue::drain() const {
+    while (!idle()) hal::idle();
+}
+
+void LcdTxQueue::setCompletionHandler(Callback f, void *context) {
+    _completion = f;
+    _completionContext = context;
+}
+
+void LcdTxQueue::setOverrunHandler(Callback f, void *context) {
+    _overrun = f;
+    _overrunContext = context;
+}
+
+LcdTxQueue::Stats LcdTxQueue::stats() const {
+    return {(uint16_t)(_wordHead - _wordTail), _maxDepth, _transfers,
+            _overruns};
+}
+
+void LcdTxQueue::kick() {
+    if (_busy || _segHead == _segTail) return;
+    const Segment &segment = _segments[_segTail & SEGMENT_MASK];
+    uint8_t bytes[LCD_TX_QUEUE_WORDS];
+    for (size_t i = 0; i < segment.size; i++) {
+        bytes[i] = (uint8_t)_words[(segment.start + i) & WORD_MASK];
+    }
+    _busy = true;
+    const uint64_t done_us =
+        hal::host::i2c_write_background(_address, bytes, segment.size);
+    hal::host::schedule(
+        done_us,
+        [](void *, uint64_t) -> uint64_t {
+            dmaIrq();
+            return 0;
+        },
+        nullptr);
+}
+
+void LcdTxQueue::onDmaDone() {
+    const Segment &segment = _segments[_segTail & SEGMENT_MASK];
+    const uint32_t settle_us = segment.settle_us;
+    _wordTail = _wordTail + segment.size;
+    _segTail = _segTail + 1;
+    _transfers++;
+
+    if (settle_us) {
+        hal::host::schedule(
+            hal::time_us() + settle_us,
+            [](void *, uint64_t) -> uint64_t {
+                alarmIrq(0);
+                return 0;
+            },
+            nullptr);
+        return;
+    }
+    onSettled();
+}
+
+void LcdTxQueue::onSettled() {
+    _busy = false;
+    kick();
+    if (idle() && _completion) _completion(_completionContext);
+}
+
+void LcdTxQueue::dmaIrq() {
+    if (_instance) _instance->onDmaDone();
+}
+
+void LcdTxQueue::alarmIrq(unsigned alarm) { _instance->onSettled(); }
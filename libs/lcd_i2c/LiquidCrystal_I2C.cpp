@@ -1,17 +1,36 @@
 // Based on the work by DFRobot
 
-#include "pico/stdlib.h"
-#include "hardware/i2c.h"
-#include "pico/binary_info.h"
+#include "Hal.h"
 
 #include "LiquidCrystal_I2C.h"
 #include <inttypes.h>
+#include <string.h>
 
 inline size_t LiquidCrystal_I2C::write(uint8_t value) {
+	if (_buffered) {
+		if (_row < LCD_MAX_ROWS && _col < LCD_MAX_COLS) {
+			_frame[_row][_col] = value;
+		}
+		if (_displaymode & LCD_ENTRYLEFT) {
+			_col++;
+		} else {
+			_col--;
+		}
+		return 1;
+	}
 	send(value, Rs);
 	return 1;
 }
 
+size_t LiquidCrystal_I2C::write(const uint8_t *buffer, size_t size) {
+	beginBatch();
+	for (size_t i = 0; i < size; i++) {
+		write(buffer[i]);
+	}
+	endBatch();
+	return size;
+}
+
 
 
 // When the display powers up, it is configured as follows:
@@ -39,6 +58,8 @@ LiquidCrystal_I2C::LiquidCrystal_I2C(uint8_t lcd_Addr,uint8_t lcd_cols,uint8_t l
   _cols = lcd_cols;
   _rows = lcd_rows;
   _backlightval = LCD_NOBACKLIGHT;
+  _displaymode = LCD_ENTRYLEFT | LCD_ENTRYSHIFTDECREMENT;
+  resetGraphs();
 }
 
 void LiquidCrystal_I2C::oled_init(){
@@ -52,18 +73,13 @@ void LiquidCrystal_I2C::init(){
 
 void LiquidCrystal_I2C::init_priv()
 {
-	i2c_init(i2c_default, 100 * 1000);
-    gpio_set_function(PICO_DEFAULT_I2C_SDA_PIN, GPIO_FUNC_I2C);
-    gpio_set_function(PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C);
-    gpio_pull_up(PICO_DEFAULT_I2C_SDA_PIN);
-    gpio_pull_up(PICO_DEFAULT_I2C_SCL_PIN);
-    // Make the I2C pins available to picotool
-    bi_decl(bi_2pins_with_func(PICO_DEFAULT_I2C_SDA_PIN, PICO_DEFAULT_I2C_SCL_PIN, GPIO_FUNC_I2C));
+	hal::i2c_setup(LCD_I2C_BAUDRATE);
 	_displayfunction = LCD_4BITMODE | LCD_1LINE | LCD_5x8DOTS;
 	begin(_cols, _rows);  
 }
 
 void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
+	invalidateGlyphs(); // CGRAM content is undefined after power up
 	if (lines > 1) {
 		_displayfunction |= LCD_2LINE;
 	}
@@ -77,11 +93,11 @@ void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
 	// SEE PAGE 45/46 FOR INITIALIZATION SPECIFICATION!
 	// according to datasheet, we need at least 40ms after power rises above 2.7V
 	// before sending commands. Arduino can turn on way befer 4.5V so we'll wait 50
-	sleep_ms(50);
+	hal::sleep_ms(50);
   
 	// Now we pull both RS and R/W low to begin commands
 	expanderWrite(_backlightval);	// reset expanderand turn backlight off (Bit 8 =1)
-	sleep_us(1000);
+	hal::sleep_us(1000);
 
   	//put the LCD into 4 bit mode
 	// this is according to the hitachi HD44780 datasheet
@@ -89,15 +105,15 @@ void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
 	
 	  // we start in 8bit mode, try to set 4 bit mode
    write4bits(0x03 << 4);
-   sleep_us(4500); // wait min 4.1ms
+   hal::sleep_us(4500); // wait min 4.1ms
    
    // second try
    write4bits(0x03 << 4);
-   sleep_us(4500); // wait min 4.1ms
+   hal::sleep_us(4500); // wait min 4.1ms
    
    // third go!
    write4bits(0x03 << 4); 
-   sleep_us(150);
+   hal::sleep_us(150);
    
    // finally, set to 4-bit interface
    write4bits(0x02 << 4); 
@@ -125,22 +141,140 @@ void LiquidCrystal_I2C::begin(uint8_t cols, uint8_t lines, uint8_t dotsize) {
 
 /********** high level commands, for the user! */
 void LiquidCrystal_I2C::clear(){
-	command(LCD_CLEARDISPLAY);// clear display, set cursor position to zero
-	sleep_us(2000);  // this command takes a long time!
+	resetGraphs();
+	if (_buffered) {
+		memset(_frame, ' ', sizeof(_frame));
+		_col = _row = 0;
+		return;
+	}
+	if (_tx) {
+		beginBatch();
+		command(LCD_CLEARDISPLAY);
+		_txSettleUs = 2000;
+		endBatch();
+	} else {
+		command(LCD_CLEARDISPLAY);// clear display, set cursor position to zero
+		waitSlowCommand();  // this command takes a long time!
+	}
+	resetShadow();
   if (_oled) setCursor(0,0);
 }
 
 void LiquidCrystal_I2C::home(){
-	command(LCD_RETURNHOME);  // set cursor position to zero
-	sleep_us(2000);  // this command takes a long time!
+	if (_buffered) {
+		_col = _row = 0;
+		return;
+	}
+	if (_tx) {
+		beginBatch();
+		command(LCD_RETURNHOME);
+		_txSettleUs = 2000;
+		endBatch();
+	} else {
+		command(LCD_RETURNHOME);  // set cursor position to zero
+		waitSlowCommand();  // this command takes a long time!
+	}
+	_deviceAddr = 0;
+}
+
+uint8_t LiquidCrystal_I2C::ddramAddr(uint8_t col, uint8_t row) const {
+	static const uint8_t row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
+	return col + row_offsets[row & 0x3];
 }
 
 void LiquidCrystal_I2C::setCursor(uint8_t col, uint8_t row){
-	int row_offsets[] = { 0x00, 0x40, 0x14, 0x54 };
 	if ( row > _numlines ) {
 		row = _numlines-1;    // we count rows starting w/0
 	}
-	command(LCD_SETDDRAMADDR | (col + row_offsets[row]));
+	if (_buffered) {
+		_col = col;
+		_row = row;
+		return;
+	}
+	command(LCD_SETDDRAMADDR | ddramAddr(col, row));
+	_deviceAddr = ddramAddr(col, row);
+}
+
+void LiquidCrystal_I2C::resetShadow() {
+	memset(_frame, ' ', sizeof(_frame));
+	memset(_device, ' ', sizeof(_device));
+	_col = _row = 0;
+	_deviceAddr = 0;
+}
+
+bool LiquidCrystal_I2C::setTxQueue(LcdTxQueue *queue) {
+	if (queue == _tx) return true;
+	if (_tx) _tx->drain();
+	if (queue && !queue->begin(_Addr, LCD_I2C_BAUDRATE)) {
+		return false;
+	}
+	_tx = queue;
+	return true;
+}
+
+void LiquidCrystal_I2C::setBuffered(bool buffered) {
+	if (buffered == _buffered) return;
+	if (buffered) {
+		// Start from a known display content
+		clear();
+	} else {
+		flush();
+		setCursor(_col, _row);
+	}
+	_buffered = buffered;
+}
+
+// Sends runs of changed cells. A cursor move costs one command byte, so
+// runs separated by a single unchanged cell are merged and the unchanged
+// cell is resent instead.
+void LiquidCrystal_I2C::flush() {
+	if (_buffered) {
+		beginBatch();
+		const uint8_t cols = _cols < LCD_MAX_COLS ? _cols : LCD_MAX_COLS;
+		const uint8_t rows = _numlines < LCD_MAX_ROWS ? _numlines : LCD_MAX_ROWS;
+		// cells are always sent left to right
+		if (!(_displaymode & LCD_ENTRYLEFT)) {
+			command(LCD_ENTRYMODESET | _displaymode | LCD_ENTRYLEFT);
+		}
+		for (uint8_t row = 0; row < rows; row++) {
+			uint8_t *frame = _frame[row];
+			uint8_t *device = _device[row];
+			uint8_t col = 0;
+			while (col < cols) {
+				if (!_repaint && frame[col] == device[col]) {
+					col++;
+					continue;
+				}
+				uint8_t last = col;
+				for (uint8_t next = col + 1; next < cols; next++) {
+					if (_repaint || frame[next] != device[next]) {
+						last = next;
+					} else if (next - last > 1) {
+						break;
+					}
+				}
+				const uint8_t addr = ddramAddr(col, row);
+				if (addr != _deviceAddr) {
+					command(LCD_SETDDRAMADDR | addr);
+					_deviceAddr = addr;
+					_stats.cursorMoves++;
+				}
+				for (; col <= last; col++) {
+					send(frame[col], Rs);
+					device[col] = frame[col];
+				}
+			}
+		}
+		if (!(_displaymode & LCD_ENTRYLEFT)) {
+			command(LCD_ENTRYMODESET | _displaymode);
+			_deviceAddr = 0xFF;
+		}
+		_repaint = false;
+		endBatch();
+	}
+	_lastFrame = _stats;
+	_stats = {};
+	_glyphFrame = _glyphClock;
 }
 
 // Turn the display on/off (quickly)
@@ -208,19 +342,101 @@ void LiquidCrystal_I2C::noAutoscroll(void) {
 // Allows us to fill the first 8 CGRAM locations
 // with custom characters
 void LiquidCrystal_I2C::createChar(uint8_t location, uint8_t charmap[]) {
-	location &= 0x7; // we only have 8 locations 0-7
-	command(LCD_SETCGRAMADDR | (location << 3));
-	for (int i=0; i<8; i++) {
-		write(charmap[i]);
-	}
+	uploadGlyph(location & 0x7, charmap); // we only have 8 locations 0-7
 }
 
 //createChar with PROGMEM input
 void LiquidCrystal_I2C::createChar(uint8_t location, char *charmap) {
-	location &= 0x7; // we only have 8 locations 0-7
+	uploadGlyph(location & 0x7, (const uint8_t *)charmap);
+}
+
+// The slot is valid before the upload is sent: a transfer dropped by the
+// tx queue, now or with an enclosing batch, invalidates it again
+void LiquidCrystal_I2C::uploadGlyph(uint8_t location, const uint8_t *rows) {
+	GlyphSlot &slot = _glyphs[location];
+	for (int i=0; i<8; i++) {
+		slot.rows[i] = rows[i] & 0x1F;
+	}
+	slot.hash = glyphHash(slot.rows);
+	slot.used = ++_glyphClock;
+	slot.valid = true;
+	_glyphStats.uploads++;
+	beginBatch();
 	command(LCD_SETCGRAMADDR | (location << 3));
 	for (int i=0; i<8; i++) {
-	    	write(*charmap++);
+		send(slot.rows[i], Rs);
+	}
+	_deviceAddr = 0xFF; // address counter now points into CGRAM
+	endBatch();
+}
+
+/************ CGRAM glyph cache **********/
+
+// FNV-1a over the 5 visible bits of each row
+uint32_t LiquidCrystal_I2C::glyphHash(const uint8_t *rows) {
+	uint32_t hash = 2166136261u;
+	for (int i=0; i<8; i++) {
+		hash = (hash ^ (rows[i] & 0x1F)) * 16777619u;
+	}
+	return hash;
+}
+
+// Slots referenced by the buffered frame, codes 8-15 alias 0-7
+uint8_t LiquidCrystal_I2C::shownGlyphs() const {
+	if (!_buffered) return 0;
+	uint8_t mask = 0;
+	for (uint8_t row = 0; row < LCD_MAX_ROWS; row++) {
+		for (uint8_t col = 0; col < LCD_MAX_COLS; col++) {
+			if (_frame[row][col] < 16) mask |= 1 << (_frame[row][col] & 0x7);
+		}
+	}
+	return mask;
+}
+
+int LiquidCrystal_I2C::glyph(const uint8_t charmap[8]) {
+	const uint32_t hash = glyphHash(charmap);
+	int victim = -1;
+	for (uint8_t i = 0; i < 8; i++) {
+		GlyphSlot &slot = _glyphs[i];
+		if (slot.valid && slot.hash == hash) {
+			bool same = true;
+			for (int j=0; j<8; j++) {
+				same &= slot.rows[j] == (charmap[j] & 0x1F);
+			}
+			if (same) {
+				slot.used = ++_glyphClock;
+				_glyphStats.hits++;
+				return i;
+			}
+		}
+	}
+	const uint8_t shown = shownGlyphs();
+	for (uint8_t i = 0; i < 8; i++) {
+		const GlyphSlot &slot = _glyphs[i];
+		if (!slot.valid) {
+			victim = i;
+			break;
+		}
+		if (slot.used > _glyphFrame || (shown & (1 << i))) continue;
+		if (victim < 0 || slot.used < _glyphs[victim].used) victim = i;
+	}
+	if (victim < 0) {
+		_glyphStats.failures++;
+		return -1;
+	}
+	if (_glyphs[victim].valid) _glyphStats.evictions++;
+	uploadGlyph(victim, charmap);
+	return victim;
+}
+
+size_t LiquidCrystal_I2C::writeGlyph(const uint8_t charmap[8]) {
+	const int code = glyph(charmap);
+	return write((uint8_t)(code < 0 ? ' ' : code));
+}
+
+void LiquidCrystal_I2C::invalidateGlyphs() {
+	for (uint8_t i = 0; i < 8; i++) {
+		_glyphs[i].valid = false;
 	}
 }
 
@@ -248,12 +464,73 @@ inline void LiquidCrystal_I2C::command(uint8_t value) {
 
 // write either command or data
 void LiquidCrystal_I2C::send(uint8_t value, uint8_t mode) {
+	// the queue only takes whole transfers, a lone byte is a batch of one
+	if (_tx && !_batch) {
+		beginBatch();
+		send(value, mode);
+		endBatch();
+		return;
+	}
+	_stats.lcdBytes++;
+	if ((mode & Rs) && _deviceAddr != 0xFF) {
+		_deviceAddr += (_displaymode & LCD_ENTRYLEFT) ? 1 : -1;
+	}
 	uint8_t highnib=value&0xf0;
 	uint8_t lownib=(value<<4)&0xf0;
+	if (_batch) {
+		if (_txlen + 6 > LCD_TX_BUFFER_SIZE) sendBatch();
+		queueNibble(highnib|mode);
+		queueNibble(lownib|mode);
+		return;
+	}
        write4bits((highnib)|mode);
 	write4bits((lownib)|mode); 
 }
 
+void LiquidCrystal_I2C::beginBatch() {
+	_batch++;
+}
+
+void LiquidCrystal_I2C::endBatch() {
+	if (_batch && --_batch == 0) sendBatch();
+}
+
+// same sequence as write4bits(): data, En high, En low
+void LiquidCrystal_I2C::queueNibble(uint8_t value) {
+	value |= _backlightval;
+	_txbuf[_txlen++] = value;
+	_txbuf[_txlen++] = value | En;
+	_txbuf[_txlen++] = value & ~En;
+}
+
+void LiquidCrystal_I2C::sendBatch() {
+	if (!_txlen) return;
+	if (_tx) {
+		if (_tx->push(_txbuf, _txlen, _txSettleUs)) {
+			_stats.i2cBytes += _txlen;
+			_stats.i2cTransactions++;
+		} else {
+			txDropped();
+		}
+		_txSettleUs = 0;
+		_txlen = 0;
+		return;
+	}
+	hal::i2c_write(_Addr, _txbuf, _txlen, false);
+	_stats.i2cBytes += _txlen;
+	_stats.i2cTransactions++;
+	_txlen = 0;
+}
+
+// Neither the display nor its CGRAM match the shadow copies any more:
+// repaint every cell on the next flush() and upload glyphs again as they
+// are requested
+void LiquidCrystal_I2C::txDropped() {
+	_repaint = true;
+	_deviceAddr = 0xFF;
+	invalidateGlyphs();
+}
+
 void LiquidCrystal_I2C::write4bits(uint8_t value) {
 	expanderWrite(value);
 	pulseEnable(value);
@@ -261,18 +538,277 @@ void LiquidCrystal_I2C::write4bits(uint8_t value) {
 
 void LiquidCrystal_I2C::expanderWrite(uint8_t _data){
 	auto data = (uint8_t)(_data | _backlightval);
-	i2c_write_blocking(PICO_DEFAULT_I2C_INSTANCE, _Addr, &data, 1, false);
+	if (_tx) {
+		if (!_tx->push(&data, 1)) {
+			txDropped();
+			return;
+		}
+	} else {
+		hal::i2c_write(_Addr, &data, 1, false);
+	}
+	_stats.i2cBytes++;
+	_stats.i2cTransactions++;
 }
 
 void LiquidCrystal_I2C::pulseEnable(uint8_t _data){
 	expanderWrite(_data | En);	// En high
-	sleep_us(1);		// enable pulse must be >450ns
+	hal::sleep_us(1);		// enable pulse must be >450ns
 	
 	expanderWrite(_data & ~En);	// En low
-	sleep_us(50);		// commands need > 37us to settle
+	// commands need > 37us to settle; with busy polling the slow ones wait
+	// on the flag and the next enable edge is two I2C writes away anyway
+	if (!_busyPolling) hal::sleep_us(50);
 } 
 
 
+/************ busy flag **********/
+
+// Slowest documented command (clear/home) is 1.52 ms at 270 kHz, allow for
+// slower oscillators before giving up
+#define LCD_BUSY_TIMEOUT_US 4000
+// Fixed delay of clear/home without polling, and the part of it no
+// controller finishes sooner, slept before the first poll
+#define LCD_SLOW_COMMAND_US 2000
+#define LCD_SLOW_COMMAND_SETTLE_US 1500
+
+bool LiquidCrystal_I2C::setBusyPolling(bool enable) {
+	if (!enable) {
+		_busyPolling = false;
+		return true;
+	}
+	if (_tx) return false;  // the DMA owns the bus
+	// A backpack without R/W reads back its own pull-ups, never the address
+	// counter we've just set
+	command(LCD_SETDDRAMADDR | 0x05);
+	const uint64_t start = hal::time_us();
+	int value = readBusyAddr();
+	_pollUs = (uint32_t)(hal::time_us() - start);
+	_busyPolling = value >= 0 && (value & 0x7F) == 0x05;
+	command(LCD_SETDDRAMADDR | 0x00);
+	_deviceAddr = 0;
+	return _busyPolling;
+}
+
+// D4-D7 are quasi-bidirectional on the PCF8574, they have to be written
+// high before the HD44780 can drive them
+int LiquidCrystal_I2C::readNibble() {
+	uint8_t out[2] = {(uint8_t)(0xF0 | Rw | _backlightval),
+	                  (uint8_t)(0xF0 | Rw | En | _backlightval)};
+	uint8_t in = 0;
+	if (hal::i2c_write(_Addr, out, 2, false) < 0 ||
+	    hal::i2c_read(_Addr, &in, 1, false) < 0 ||
+	    hal::i2c_write(_Addr, out, 1, false) < 0) {
+		return -1;
+	}
+	_stats.i2cBytes += 4;
+	_stats.i2cTransactions += 3;
+	return in & 0xF0;
+}
+
+int LiquidCrystal_I2C::readBusyAddr() {
+	int high = readNibble();
+	if (high < 0) return high;
+	int low = readNibble();
+	if (low < 0) return low;
+	_busyStats.polls++;
+	return high | (low >> 4);
+}
+
+bool LiquidCrystal_I2C::waitReady(uint32_t timeout_us) {
+	const uint64_t start = hal::time_us();
+	for (;;) {
+		int value = readBusyAddr();
+		const uint32_t elapsed = (uint32_t)(hal::time_us() - start);
+		if (value < 0) return false;
+		if (!(value & 0x80)) {
+			_busyStats.lastWaitUs = elapsed;
+			if (elapsed > _busyStats.maxWaitUs) _busyStats.maxWaitUs = elapsed;
+			return true;
+		}
+		if (elapsed > timeout_us) {
+			_busyStats.timeouts++;
+			return false;
+		}
+	}
+}
+
+// A poll is four I2C transfers, 1.26 ms at 100 kHz: polling only pays off
+// when one poll after the settle time still ends before the fixed delay
+void LiquidCrystal_I2C::waitSlowCommand() {
+	if (_busyPolling &&
+	    LCD_SLOW_COMMAND_SETTLE_US + _pollUs < LCD_SLOW_COMMAND_US) {
+		hal::sleep_us(LCD_SLOW_COMMAND_SETTLE_US);
+		if (waitReady(LCD_BUSY_TIMEOUT_US)) return;
+	}
+	hal::sleep_us(LCD_SLOW_COMMAND_US);
+}
+
+uint32_t LiquidCrystal_I2C::measureCommandUs(uint8_t cmd) {
+	if (!_busyPolling || _tx) return 0;
+	command(cmd);
+	// the command may have changed the display behind the shadow copy
+	_deviceAddr = 0xFF;
+	_repaint = true;
+	if (!waitReady(LCD_BUSY_TIMEOUT_US)) return 0;
+	// The flag is sampled once per poll: the controller got ready during
+	// the poll before the one which saw it ready, whose time is not busy
+	// time
+	const uint32_t waited = _busyStats.lastWaitUs;
+	return waited > _pollUs ? waited - _pollUs : 0;
+}
+
+uint8_t LiquidCrystal_I2C::status(){
+	if (_tx) return 0;
+	int value = readBusyAddr();
+	return value < 0 ? 0 : value;
+}
+
+
+/************ bar graphs **********/
+
+namespace {
+
+// glyph for each fill level of one cell, generated at compile time
+struct BarGlyphs {
+	uint8_t levels;  // cell width or height in pixels
+	uint8_t rows[9][8];
+};
+
+constexpr BarGlyphs horizontalGlyphs(bool framed) {
+	BarGlyphs set = {5, {}};
+	for (uint8_t level = 0; level <= 5; level++) {
+		const uint8_t fill = (0x1F << (5 - level)) & 0x1F;
+		for (uint8_t r = 0; r < 8; r++) {
+			if (!framed) {
+				set.rows[level][r] = fill;
+			} else if (r == 0 || r == 7) {
+				set.rows[level][r] = 0x1F;
+			} else if (r >= 2 && r <= 5) {
+				set.rows[level][r] = fill;
+			}
+		}
+	}
+	return set;
+}
+
+constexpr BarGlyphs verticalGlyphs() {
+	BarGlyphs set = {8, {}};
+	for (uint8_t level = 0; level <= 8; level++) {
+		for (uint8_t r = 8 - level; r < 8; r++) {
+			set.rows[level][r] = 0x1F;
+		}
+	}
+	return set;
+}
+
+constexpr BarGlyphs c_BAR_GLYPHS[] = {
+	verticalGlyphs(),          // LCD_BARGRAPH_VERTICAL
+	horizontalGlyphs(false),   // LCD_BARGRAPH_HORIZONTAL
+	horizontalGlyphs(true),    // LCD_BARGRAPH_FRAMED
+};
+
+constexpr uint8_t c_BAR_TYPES = sizeof(c_BAR_GLYPHS) / sizeof(c_BAR_GLYPHS[0]);
+
+// ROM characters for the empty and the full cell
+constexpr uint8_t c_BAR_BLANK = ' ';
+constexpr uint8_t c_BAR_BLOCK = 0xFF;
+
+}  // namespace
+
+void LiquidCrystal_I2C::resetGraphs() {
+	for (uint8_t i = 0; i < LCD_BARGRAPH_SLOTS; i++) {
+		_graphs[i].type = 0xFF;
+	}
+}
+
+// Empty and full cells of the plain styles come from the character ROM,
+// which leaves CGRAM to the partial cells
+uint8_t LiquidCrystal_I2C::graphCode(uint8_t type, uint8_t level) {
+	const BarGlyphs &set = c_BAR_GLYPHS[type];
+	if (type != LCD_BARGRAPH_FRAMED) {
+		if (level == 0) return c_BAR_BLANK;
+		if (level == set.levels) return c_BAR_BLOCK;
+	}
+	const int code = glyph(set.rows[level]);
+	return code < 0 ? c_BAR_BLANK : code;
+}
+
+uint8_t LiquidCrystal_I2C::init_bargraph(uint8_t graphtype) {
+	if (graphtype >= c_BAR_TYPES) return 1;
+	_graphType = graphtype;
+	// warm the glyph cache, drawing the first frame uploads nothing
+	const BarGlyphs &set = c_BAR_GLYPHS[graphtype];
+	for (uint8_t level = 0; level <= set.levels; level++) {
+		graphCode(graphtype, level);
+	}
+	return 0;
+}
+
+void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_col_end) {
+	const uint8_t type = _graphType == LCD_BARGRAPH_VERTICAL ? LCD_BARGRAPH_HORIZONTAL : _graphType;
+	drawGraph(type, row, column, len, pixel_col_end);
+}
+
+void LiquidCrystal_I2C::draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_row_end) {
+	drawGraph(LCD_BARGRAPH_VERTICAL, row, column, len, pixel_row_end);
+}
+
+void LiquidCrystal_I2C::drawGraph(uint8_t type, uint8_t row, uint8_t col, uint8_t len, uint8_t pixels) {
+	const uint8_t step = c_BAR_GLYPHS[type].levels;
+	if (!len) return;
+	if (pixels > len * step) pixels = len * step;
+
+	// Only the partial cell (and the empty/full ones of the framed style)
+	// use CGRAM. Requesting them every draw keeps them from being evicted
+	// while they're on screen.
+	const uint8_t codes[3] = {graphCode(type, 0), graphCode(type, step),
+	                          graphCode(type, pixels % step)};
+
+	BarGraph *graph = nullptr;
+	for (uint8_t i = 0; i < LCD_BARGRAPH_SLOTS; i++) {
+		BarGraph &g = _graphs[i];
+		if (g.type == type && g.row == row && g.col == col && g.len == len) {
+			graph = &g;
+			break;
+		}
+	}
+	uint8_t first = 0;
+	uint8_t last = len - 1;
+	if (graph && !memcmp(graph->codes, codes, sizeof(codes))) {
+		if (graph->pixels == pixels) return;
+		// cells between the old and the new end of the bar
+		const uint8_t lo = graph->pixels < pixels ? graph->pixels : pixels;
+		const uint8_t hi = graph->pixels < pixels ? pixels : graph->pixels;
+		first = lo / step;
+		last = (hi - 1) / step;
+	} else if (!graph) {
+		graph = &_graphs[_graphNext];
+		_graphNext = (_graphNext + 1) % LCD_BARGRAPH_SLOTS;
+		graph->type = type;
+		graph->row = row;
+		graph->col = col;
+		graph->len = len;
+	}
+	graph->pixels = pixels;
+	memcpy(graph->codes, codes, sizeof(codes));
+
+	beginBatch();
+	if (type != LCD_BARGRAPH_VERTICAL) {
+		setCursor(col + first, row);
+	}
+	for (uint8_t i = first; i <= last; i++) {
+		const int16_t fill = (int16_t)pixels - i * step;
+		const uint8_t code = fill <= 0 ? codes[0] : fill >= step ? codes[1] : codes[2];
+		if (type == LCD_BARGRAPH_VERTICAL) {
+			if (i > row) break;  // ran off the top of the display
+			setCursor(col, row - i);
+		}
+		write(code);
+	}
+	endBatch();
+}
+
+
 // Alias functions
 
 void LiquidCrystal_I2C::cursor_on(){
@@ -316,11 +852,7 @@ void LiquidCrystal_I2C::printstr(const char c[]){
 void LiquidCrystal_I2C::off(){}
 void LiquidCrystal_I2C::on(){}
 void LiquidCrystal_I2C::setDelay (int cmdDelay,int charDelay) {}
-uint8_t LiquidCrystal_I2C::status(){return 0;}
 uint8_t LiquidCrystal_I2C::keypad (){return 0;}
-uint8_t LiquidCrystal_I2C::init_bargraph(uint8_t graphtype){return 0;}
-void LiquidCrystal_I2C::draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_col_end){}
-void LiquidCrystal_I2C::draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_row_end){}
 void LiquidCrystal_I2C::setContrast(uint8_t new_val){}
 #pragma GCC diagnostic pop
 	
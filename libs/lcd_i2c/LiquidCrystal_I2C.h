@@ -2,6 +2,7 @@
 
 #include <inttypes.h>
 #include "Print.h" 
+#include "LcdTxQueue.h"
 
 // commands
 #define LCD_CLEARDISPLAY 0x01
@@ -45,10 +46,52 @@
 #define LCD_BACKLIGHT 0x08
 #define LCD_NOBACKLIGHT 0x00
 
+// shadow framebuffer size, enough for 20x4 modules
+#define LCD_MAX_COLS 20
+#define LCD_MAX_ROWS 4
+
+// batched PCF8574 stream, 6 bytes per HD44780 byte: a full 16x2 frame
+// with its two cursor moves fits into one transfer
+#define LCD_TX_BUFFER_SIZE 240
+
+#define LCD_I2C_BAUDRATE (100 * 1000)
+
+// bar graph styles for init_bargraph()
+#define LCD_BARGRAPH_VERTICAL 0
+#define LCD_BARGRAPH_HORIZONTAL 1
+#define LCD_BARGRAPH_FRAMED 2  // horizontal, inside a one pixel frame
+
+// bar graphs remembered for incremental redraw
+#define LCD_BARGRAPH_SLOTS 4
+
 #define En 0b00000100  // Enable bit
 #define Rw 0b00000010  // Read/Write bit
 #define Rs 0b00000001  // Register select bit
 
+// bus traffic of one frame, ie. everything sent since the previous flush()
+struct LcdFrameStats {
+  uint16_t lcdBytes;         // bytes (commands + data) sent to the HD44780
+  uint16_t cursorMoves;      // set DDRAM address commands issued by flush()
+  uint16_t i2cBytes;         // bytes written to the PCF8574
+  uint16_t i2cTransactions;  // start/address/stop sequences on the bus
+};
+
+// busy flag polling measurements, all times in microseconds
+struct LcdBusyStats {
+  uint32_t polls;       // busy flag reads
+  uint32_t timeouts;    // waits that gave up and fell back to a delay
+  uint32_t lastWaitUs;  // duration of the last wait
+  uint32_t maxWaitUs;   // longest wait so far
+};
+
+// CGRAM glyph cache counters
+struct LcdGlyphStats {
+  uint32_t hits;       // glyph() found the pattern resident
+  uint32_t uploads;    // patterns written to CGRAM
+  uint32_t evictions;  // uploads that replaced another pattern
+  uint32_t failures;   // no slot could be freed
+};
+
 class LiquidCrystal_I2C : public Print {
 public:
   LiquidCrystal_I2C(uint8_t lcd_Addr,uint8_t lcd_cols,uint8_t lcd_rows);
@@ -76,13 +119,69 @@ public:
   void createChar(uint8_t, uint8_t[]);
   void createChar(uint8_t location, char *charmap);
   // Example: 	const char bell[8] PROGMEM = {B00100,B01110,B01110,B01110,B11111,B00000,B00100,B00000};
+
+  // CGRAM glyph cache: returns the character code (0-7) of a slot holding
+  // charmap, uploading it first if it isn't resident. The least recently
+  // used slot is replaced. Slots requested since the last flush() or still
+  // shown in the buffered frame are not evicted, -1 when none is left.
+  int glyph(const uint8_t charmap[8]);
+  // glyph() at the cursor, a blank if no slot is available
+  size_t writeGlyph(const uint8_t charmap[8]);
+  // Forget what CGRAM holds, eg. after something else wrote to it
+  void invalidateGlyphs();
+  const LcdGlyphStats &glyphStats() const { return _glyphStats; }
   
   void setCursor(uint8_t, uint8_t); 
   virtual size_t write(uint8_t);
+  virtual size_t write(const uint8_t *buffer, size_t size);
+  using Print::write;
   void command(uint8_t);
+
+  // Everything sent between beginBatch() and the matching endBatch() is
+  // encoded into one PCF8574 byte stream and written in as few I2C
+  // transfers as the buffer allows. At the I2C byte rate no extra delay is
+  // needed between the enable pulses. Calls may nest.
+  void beginBatch();
+  void endBatch();
+
+  // Asynchronous output: every transfer is appended to the queue and sent
+  // by DMA, clear() and home() wait for the controller in a hardware alarm
+  // instead of sleeping. Transfers dropped on a queue overrun trigger a
+  // full repaint on the next flush() and empty the glyph cache, so glyphs
+  // are uploaded again. Pass nullptr to go back to blocking writes once the
+  // queue has drained.
+  bool setTxQueue(LcdTxQueue *queue);
+  LcdTxQueue *txQueue() const { return _tx; }
+
+  // Busy flag polling: slow commands (clear, home) read the busy flag
+  // through the backpack's R/W line and return as soon as the controller is
+  // ready, instead of sleeping for the worst case. Enabling probes the
+  // module first and returns false if R/W isn't wired, the driver then
+  // keeps the timed delays. Not used while a tx queue is attached.
+  bool setBusyPolling(bool enable);
+  bool busyPolling() const { return _busyPolling; }
+  const LcdBusyStats &busyStats() const { return _busyStats; }
+  // Issue a command and measure how long the controller stays busy, to
+  // within +-pollUs(): the wait less the poll which saw the flag clear.
+  // Returns 0 if busy polling is not available.
+  uint32_t measureCommandUs(uint8_t cmd);
+  // Bus time of one busy flag read, measured when polling is enabled
+  uint32_t pollUs() const { return _pollUs; }
+  // Busy flag (bit 7) and address counter, negative on bus error
+  int readBusyAddr();
+  // Wait for the busy flag to clear, false on timeout or bus error
+  bool waitReady(uint32_t timeout_us);
   void init();
   void oled_init();
 
+  // Shadow framebuffer: when buffered, print/write/setCursor/clear/home only
+  // update RAM and flush() sends the cells that differ from what the display
+  // already holds. Autoscroll is not supported while buffered.
+  void setBuffered(bool buffered);
+  bool buffered() const { return _buffered; }
+  virtual void flush();
+  const LcdFrameStats &frameStats() const { return _lastFrame; }
+
 ////compatibility API function aliases
 void blink_on();						// alias for blink()
 void blink_off();       					// alias for noBlink()
@@ -92,24 +191,34 @@ void setBacklight(uint8_t new_val);				// alias for backlight() and nobacklight(
 void load_custom_character(uint8_t char_num, uint8_t *rows);	// alias for createChar()
 void printstr(const char[]);
 
+uint8_t status();						// busy flag and address counter
+
+// Bar graphs, one pixel resolution. Only cells whose fill level changed
+// since the previous draw at the same place are written, so the cells must
+// not be overwritten in between; clear() starts over.
+uint8_t init_bargraph(uint8_t graphtype);	// 0 on success
+void draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_col_end);
+void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_row_end);	// grows up from row
+
 ////Unsupported API functions (not implemented in this library)
-uint8_t status();
 void setContrast(uint8_t new_val);
 uint8_t keypad();
 void setDelay(int,int);
 void on();
 void off();
-uint8_t init_bargraph(uint8_t graphtype);
-void draw_horizontal_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_col_end);
-void draw_vertical_graph(uint8_t row, uint8_t column, uint8_t len,  uint8_t pixel_col_end);
 	 
 
 private:
   void init_priv();
+  void resetShadow();
+  uint8_t ddramAddr(uint8_t col, uint8_t row) const;
   void send(uint8_t, uint8_t);
   void write4bits(uint8_t);
   void expanderWrite(uint8_t);
   void pulseEnable(uint8_t);
+  void queueNibble(uint8_t);
+  void sendBatch();
+  void txDropped();
   uint8_t _Addr;
   uint8_t _displayfunction;
   uint8_t _displaycontrol;
@@ -119,4 +228,50 @@ private:
   uint8_t _cols;
   uint8_t _rows;
   uint8_t _backlightval;
-};
\ No newline at end of file
+  bool _buffered = false;
+  uint8_t _col = 0;
+  uint8_t _row = 0;
+  uint8_t _deviceAddr = 0xFF;  // DDRAM address counter, 0xFF when unknown
+  uint8_t _frame[LCD_MAX_ROWS][LCD_MAX_COLS];
+  uint8_t _device[LCD_MAX_ROWS][LCD_MAX_COLS];
+  LcdTxQueue *_tx = nullptr;
+  struct GlyphSlot {
+    uint32_t hash;
+    uint32_t used;  // _glyphClock of the last request
+    bool valid;
+    uint8_t rows[8];
+  };
+  GlyphSlot _glyphs[8] = {};
+  uint32_t _glyphClock = 0;
+  uint32_t _glyphFrame = 0;  // _glyphClock at the last flush()
+  LcdGlyphStats _glyphStats = {};
+  static uint32_t glyphHash(const uint8_t *rows);
+  uint8_t shownGlyphs() const;
+  void uploadGlyph(uint8_t location, const uint8_t *rows);
+  struct BarGraph {
+    uint8_t row;
+    uint8_t col;
+    uint8_t len;
+    uint8_t type;     // LCD_BARGRAPH_*, 0xFF for an unused entry
+    uint8_t pixels;   // fill of the last draw
+    uint8_t codes[3]; // empty, full and partial cell codes of the last draw
+  };
+  BarGraph _graphs[LCD_BARGRAPH_SLOTS];
+  uint8_t _graphType = LCD_BARGRAPH_HORIZONTAL;
+  uint8_t _graphNext = 0;
+  void resetGraphs();
+  void drawGraph(uint8_t type, uint8_t row, uint8_t col, uint8_t len, uint8_t pixels);
+  uint8_t graphCode(uint8_t type, uint8_t level);
+  bool _busyPolling = false;
+  LcdBusyStats _busyStats = {};
+  uint32_t _pollUs = 0;
+  int readNibble();
+  void waitSlowCommand();
+  bool _repaint = false;
+  uint8_t _batch = 0;
+  uint16_t _txlen = 0;
+  uint16_t _txSettleUs = 0;
+  uint8_t _txbuf[LCD_TX_BUFFER_SIZE];
+  LcdFrameStats _stats = {};
+  LcdFrameStats _lastFrame = {};
+};
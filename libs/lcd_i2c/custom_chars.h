@@ -8,24 +8,6 @@ byte chStartEmpty[8] = {0b00111, 0b11000, 0b10000, 0b10000,
 byte chStartFull[8] = {0b00111, 0b11000, 0b10011, 0b10111,
                       0b10111, 0b10011, 0b11000, 0b00111};
 
-byte caseEmpty[8] = {0b11111, 0b00000, 0b00000, 0b00000,
-                    0b00000, 0b00000, 0b00000, 0b11111};
-
-byte chCase1[8] = {0b11111, 0b00000, 0b10000, 0b10000,
-                  0b10000, 0b10000, 0b00000, 0b11111};
-
-byte chCase2[8] = {0b11111, 0b00000, 0b11000, 0b11000,
-                    0b11000, 0b11000, 0b00000, 0b11111};
-
-byte chCase3[8] = {0b11111, 0b00000, 0b11100, 0b11100,
-                     0b11100, 0b11100, 0b00000, 0b11111};
-
-byte chCase4[8] = {0b11111, 0b00000, 0b11110, 0b11110,
-                      0b11110, 0b11110, 0b00000, 0b11111};
-
-byte chCase5[8] = {0b11111, 0b00000, 0b11111, 0b11111,
-                    0b11111, 0b11111, 0b00000, 0b11111};
-
 byte chEndEmpty[8] = {0b11110, 0b00011, 0b00001, 0b00001,
                    0b00001, 0b00001, 0b00011, 0b11110};
 
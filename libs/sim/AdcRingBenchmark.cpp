@@ -0,0 +1,145 @@
+#include "AdcRingBenchmark.h"
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+
+#include "AdcDma.h"
+#include "HalHost.h"
+
+namespace {
+
+constexpr size_t BLOCK_SAMPLES = 20;
+constexpr size_t BLOCKS = 4;
+constexpr uint32_t SAMPLE_RATE = 10000;
+constexpr uint64_t PERIOD_US = 1000000U / SAMPLE_RATE;
+constexpr uint64_t BLOCK_US = BLOCK_SAMPLES * PERIOD_US;
+constexpr unsigned RUN_BLOCKS = 10000;
+constexpr unsigned STALL_BLOCKS = 25;
+
+typedef AdcDma<BLOCK_SAMPLES, BLOCKS> Ring;
+
+uint32_t s_completions = 0;
+
+uint16_t ramp(unsigned, uint64_t t_us, void *) {
+    return (uint16_t)((t_us / PERIOD_US) & ADC_RESULT_MASK);
+}
+
+void count_completion() { s_completions++; }
+
+// consecutive conversions, the last one just before the timestamp
+bool holds_its_conversions(const AdcBlock &block) {
+    if (block.count != BLOCK_SAMPLES) return false;
+    for (size_t i = 1; i < block.count; i++) {
+        if (block.samples[i] != ((block.samples[i - 1] + 1) & ADC_RESULT_MASK))
+            return false;
+    }
+    const uint64_t last = block.timestamp_us / PERIOD_US - 1;
+    return block.samples[block.count - 1] == (last & ADC_RESULT_MASK);
+}
+
+// Drain the ring block by block as the DMA completes them
+bool check_laps(Ring &ring, uint64_t &t_us, uint32_t &sequence,
+                uint64_t &timestamp_us) {
+    bool ok = true;
+    const auto start = std::chrono::steady_clock::now();
+    for (unsigned n = 0; n < RUN_BLOCKS; n++) {
+        t_us += BLOCK_US;
+        hal::host::advance_to(t_us);
+        const AdcBlock *block;
+        while ((block = ring.acquire())) {
+            ok &= block->sequence == sequence &&
+                  block->timestamp_us == timestamp_us + BLOCK_US &&
+                  holds_its_conversions(*block);
+            sequence++;
+            timestamp_us = block->timestamp_us;
+            ring.release();
+        }
+    }
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      RUN_BLOCKS;
+    ok &= ring.overruns() == 0 && sequence == ring.blocks();
+    printf("ADC ring: %u blocks of %u in order over %u laps, no overrun, "
+           "%.0f ns per block with the simulated DMA  %s\n",
+           (unsigned)sequence, (unsigned)BLOCK_SAMPLES,
+           (unsigned)(sequence / BLOCKS), ns, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+// Stall holding the oldest block until the ring overflows
+bool check_overrun(Ring &ring, uint64_t &t_us, uint32_t sequence,
+                   uint64_t timestamp_us) {
+    t_us += BLOCK_US;
+    hal::host::advance_to(t_us);
+    const AdcBlock *held = ring.acquire();
+    if (!held) {
+        printf("ADC ring: no block to hold  FAIL\n");
+        return false;
+    }
+    const AdcBlock copy = *held;
+    uint16_t samples[BLOCK_SAMPLES];
+    for (size_t i = 0; i < BLOCK_SAMPLES; i++) samples[i] = held->samples[i];
+
+    t_us += STALL_BLOCKS * BLOCK_US;
+    hal::host::advance_to(t_us);
+    const uint32_t pending = ring.pending();
+    bool ok = pending == BLOCKS && ring.overruns() > 0;
+    bool intact = held->sequence == copy.sequence &&
+                  held->timestamp_us == copy.timestamp_us;
+    for (size_t i = 0; i < BLOCK_SAMPLES; i++) {
+        intact &= held->samples[i] == samples[i];
+    }
+    ok &= intact && copy.sequence == sequence &&
+          holds_its_conversions(copy);
+    ring.release();
+
+    // the rest of the ring, then the blocks after the gap
+    uint32_t dropped = 0;
+    timestamp_us = copy.timestamp_us;
+    sequence = copy.sequence + 1;
+    for (unsigned i = 0; i < 2 * BLOCKS; i++) {
+        t_us += BLOCK_US;
+        hal::host::advance_to(t_us);
+        const AdcBlock *block;
+        while ((block = ring.acquire())) {
+            const uint64_t gap = block->timestamp_us - timestamp_us;
+            ok &= block->sequence == sequence && gap % BLOCK_US == 0 &&
+                  gap >= BLOCK_US && holds_its_conversions(*block);
+            dropped += (uint32_t)(gap / BLOCK_US - 1);
+            sequence++;
+            timestamp_us = block->timestamp_us;
+            ring.release();
+        }
+    }
+    // every completed block was either handed out or counted as dropped
+    ok &= dropped == ring.overruns() &&
+          s_completions == ring.blocks() + ring.overruns();
+    printf("ADC ring: stalled %u blocks holding one, %u pending, %u "
+           "overruns, %u blocks missing after the gap, held block %s  %s\n",
+           STALL_BLOCKS, (unsigned)pending, (unsigned)ring.overruns(),
+           (unsigned)dropped, intact ? "intact" : "overwritten",
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+}  // namespace
+
+int adc_ring_benchmark() {
+    static Ring s_ring;
+    hal::host::set_analog_source(ramp, nullptr);
+    if (!s_ring.begin(0x3U, SAMPLE_RATE, count_completion)) {
+        printf("ADC ring: begin() failed  FAIL\n");
+        return 1;
+    }
+    uint64_t t_us = hal::time_us();
+    s_ring.start();
+    uint32_t sequence = 0;
+    uint64_t timestamp_us = t_us;
+    bool ok = check_laps(s_ring, t_us, sequence, timestamp_us);
+    ok &= check_overrun(s_ring, t_us, sequence, timestamp_us);
+    s_ring.stop();
+    hal::host::set_analog_source(nullptr, nullptr);
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+#pragma once
+
+/// @brief Block ring of AdcDma, driven by the host ADC DMA stand-in
+/// @details The simulated ADC converts a ramp, one count per conversion,
+/// so every block shows whether it holds the conversions its timestamp
+/// says. The ring is first drained as fast as it fills, for many laps,
+/// then the consumer stalls holding a block: the ring has to fill, count
+/// the dropped blocks as overruns and leave the held block intact, and
+/// afterwards hand out the remaining blocks in order with a gap of exactly
+/// the dropped ones.
+/// @return 0 if every check passed, 1 otherwise
+int adc_ring_benchmark();
@@ -0,0 +1,151 @@
+#include "EngineVacuum.h"
+
+#include <cmath>
+
+namespace {
+
+constexpr double CYCLE_DEG = 720.0;
+constexpr double PI = 3.14159265358979323846;
+// ignition ringing is dropped after this many time constants
+constexpr double SPARK_SPAN = 6.0;
+
+double wrap(double deg) {
+    deg = std::fmod(deg, CYCLE_DEG);
+    return deg < 0 ? deg + CYCLE_DEG : deg;
+}
+
+}  // namespace
+
+EngineVacuum::EngineVacuum(const Config &config)
+    : _config(config), _rng(config.seed ? config.seed : 1) {
+    Config &c = _config;
+    if (c.cylinders < 1) c.cylinders = 1;
+    if (c.cylinders > MAX_CYLINDERS) c.cylinders = MAX_CYLINDERS;
+
+    // Slot k fires (compression TDC) at angle[k]; its intake stroke starts
+    // one revolution later, at the overlap TDC
+    double angle = 0;
+    for (unsigned k = 0; k < c.cylinders; k++) {
+        unsigned cyl = (c.firing_order[k] - 1U) % c.cylinders;
+        _firing_deg[k] = wrap(angle - c.advance_deg);
+        _intake_deg[cyl] = wrap(angle + CYCLE_DEG / 2);
+        angle += c.firing_interval_deg[k] ? c.firing_interval_deg[k]
+                                          : CYCLE_DEG / c.cylinders;
+    }
+}
+
+double EngineVacuum::rpm(uint64_t t_us) const {
+    const Config &c = _config;
+    const double s = t_us / 1e6;
+    if (c.rpm_end <= 0 || c.ramp_s <= 0) return c.rpm;
+    if (s >= c.ramp_s) return c.rpm_end;
+    return c.rpm + (c.rpm_end - c.rpm) * s / c.ramp_s;
+}
+
+double EngineVacuum::crank_deg(uint64_t t_us) const {
+    // 1 rpm is 6 degrees per second; integral of the linear ramp
+    const Config &c = _config;
+    const double s = t_us / 1e6;
+    if (c.rpm_end <= 0 || c.ramp_s <= 0) return 6.0 * c.rpm * s;
+    const double ramp = s < c.ramp_s ? s : c.ramp_s;
+    const double accel = (c.rpm_end - c.rpm) / c.ramp_s;
+    double revs = c.rpm * ramp + 0.5 * accel * ramp * ramp;
+    if (s > c.ramp_s) revs += c.rpm_end * (s - c.ramp_s);
+    return 6.0 * revs;
+}
+
+// Depth of one intake pulse, 0-1, phase counted from the valve opening
+double EngineVacuum::pulse(double phase_deg) const {
+    const Config &c = _config;
+    if (phase_deg >= c.intake_deg) return 0;
+    const double x = phase_deg / c.intake_deg;
+    const double peak =
+        c.pulse_peak > 0.01 ? (c.pulse_peak < 0.99 ? c.pulse_peak : 0.99)
+                            : 0.01;
+    switch (c.shape) {
+        case PulseShape::Sine:
+            return std::sin(PI * x);
+        case PulseShape::Skewed:
+            return x < peak ? std::sin(PI / 2 * x / peak)
+                            : std::cos(PI / 2 * (x - peak) / (1 - peak));
+        case PulseShape::Trapezoid: {
+            const double edge = peak < 0.5 ? peak : 1 - peak;
+            if (x < edge) return x / edge;
+            if (x > 1 - edge) return (1 - x) / edge;
+            return 1;
+        }
+    }
+    return 0;
+}
+
+double EngineVacuum::pressure_mbar(unsigned channel, uint64_t t_us) const {
+    const Config &c = _config;
+    if (channel >= MAX_CHANNELS) return c.base_mbar;
+    const unsigned own = (c.channel_cylinder[channel] - 1U) % c.cylinders;
+    const double crank = crank_deg(t_us);
+
+    double depth = 0;
+    for (unsigned cyl = 0; cyl < c.cylinders; cyl++) {
+        const double scale = c.pulse_scale[cyl] ? c.pulse_scale[cyl] : 1;
+        const double p = scale * pulse(wrap(crank - _intake_deg[cyl]));
+        depth += cyl == own ? p : c.crosstalk * p;
+    }
+    return c.base_mbar + c.imbalance_mbar[channel] - c.pulse_mbar * depth;
+}
+
+// Ringing left by the most recent firings, in mV
+double EngineVacuum::spark(double crank, double rpm) const {
+    const Config &c = _config;
+    if (c.spark_mv <= 0 || rpm <= 0) return 0;
+    const double deg_per_us = 6.0 * rpm / 1e6;
+    double mv = 0;
+    for (unsigned k = 0; k < c.cylinders; k++) {
+        const double dt_us = wrap(crank - _firing_deg[k]) / deg_per_us;
+        if (dt_us > SPARK_SPAN * c.spark_us) continue;
+        mv += c.spark_mv * std::exp(-dt_us / c.spark_us) *
+              std::cos(2 * PI * c.spark_hz * dt_us / 1e6);
+    }
+    return mv;
+}
+
+// Irwin-Hall approximation of a unit normal from an xorshift32 stream
+double EngineVacuum::gaussian() {
+    double sum = 0;
+    for (int i = 0; i < 12; i++) {
+        _rng ^= _rng << 13;
+        _rng ^= _rng >> 17;
+        _rng ^= _rng << 5;
+        sum += _rng / 4294967296.0;
+    }
+    return sum - 6.0;
+}
+
+double EngineVacuum::sensor_mv(unsigned channel, uint64_t t_us) {
+    const Config &c = _config;
+    double mbar = pressure_mbar(channel, t_us);
+    if (c.noise_mbar > 0) mbar += c.noise_mbar * gaussian();
+
+    double mv = c.sensor_mv_min + (mbar - c.sensor_mbar_min) *
+                                      (c.sensor_mv_max - c.sensor_mv_min) /
+                                      (c.sensor_mbar_max - c.sensor_mbar_min);
+    mv += spark(crank_deg(t_us), rpm(t_us));
+    if (mv < c.sensor_mv_min) mv = c.sensor_mv_min;
+    if (mv > c.sensor_mv_max) mv = c.sensor_mv_max;
+    return mv;
+}
+
+uint16_t EngineVacuum::millivolts(unsigned channel, uint64_t t_us) {
+    return (uint16_t)std::lround(sensor_mv(channel, t_us));
+}
+
+uint16_t EngineVacuum::counts(unsigned channel, uint64_t t_us) {
+    double counts = sensor_mv(channel, t_us) * 4096 / 3300;
+    if (_config.adc_noise_lsb > 0) counts += _config.adc_noise_lsb * gaussian();
+    const long rounded = std::lround(counts);
+    return rounded < 0 ? 0 : rounded > 4095 ? 4095 : (uint16_t)rounded;
+}
+
+uint16_t EngineVacuum::analog_source(unsigned input, uint64_t t_us,
+                                     void *context) {
+    return static_cast<EngineVacuum *>(context)->counts(input, t_us);
+}
@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Synthetic intake vacuum of a multi-cylinder engine.
+/// @details Each ADC channel watches the intake runner of one cylinder. The
+/// runner sits at a base absolute pressure which the cylinder pulls down
+/// once per 720 degree cycle, while its intake valve is open; the pulses of
+/// the other cylinders leak in through the shared airbox. Ignition adds a
+/// decaying ringing to every channel at each firing. The pressure goes
+/// through the sensor's linear transfer to mV, clamped to its output range,
+/// which is the domain the firmware's averaging works in. The waveform is a
+/// function of time, so it can be sampled at any rate, but the noise is
+/// drawn from one generator and wants the samples in time order.
+class EngineVacuum {
+public:
+    static constexpr unsigned MAX_CYLINDERS = 8;
+    static constexpr unsigned MAX_CHANNELS = 4;
+
+    enum class PulseShape : uint8_t {
+        Sine,      // symmetric half sine
+        Skewed,    // fast pull-down, slow recovery, peak at pulse_peak
+        Trapezoid  // flat bottom between the pulse_peak ramps
+    };
+
+    struct Config {
+        /// Engine speed, linear ramp from rpm to rpm_end over ramp_s
+        double rpm = 1200;
+        double rpm_end = 0;  // 0 keeps rpm
+        double ramp_s = 0;
+
+        uint8_t cylinders = 2;
+        /// Cylinder numbers (1-based) in firing order
+        uint8_t firing_order[MAX_CYLINDERS] = {1, 2, 3, 4, 5, 6, 7, 8};
+        /// Crank angle between consecutive firings, 0 for even firing. Eg.
+        /// a 90 degree V-twin fires 270 then 450 degrees apart.
+        uint16_t firing_interval_deg[MAX_CYLINDERS] = {};
+        /// Cylinder (1-based) whose runner each channel is connected to
+        uint8_t channel_cylinder[MAX_CHANNELS] = {1, 2, 3, 4};
+
+        /// Absolute runner pressure between pulses
+        double base_mbar = 650;
+        /// Pull-down of the pulse at its deepest point
+        double pulse_mbar = 350;
+        /// Intake valve open duration, crank degrees
+        double intake_deg = 230;
+        PulseShape shape = PulseShape::Skewed;
+        /// Position of the deepest point within the pulse, 0-1
+        double pulse_peak = 0.35;
+        /// Fraction of the other cylinders' pulses seen through the airbox
+        double crosstalk = 0.1;
+        /// Per channel offset of the base pressure, eg. a carb out of
+        /// balance, negative is more vacuum
+        double imbalance_mbar[MAX_CHANNELS] = {};
+        /// Per cylinder factor of pulse_mbar, eg. a leaking valve pulls
+        /// less; 0 is taken as 1
+        double pulse_scale[MAX_CYLINDERS] = {};
+        /// Gaussian noise, rms
+        double noise_mbar = 3;
+
+        /// Ignition ringing at the sensor output, 0 disables it
+        double spark_mv = 120;
+        double spark_us = 60;     // decay time constant
+        double spark_hz = 25000;  // ringing frequency
+        /// Firing point before the top dead centre of compression
+        double advance_deg = 10;
+
+        /// Sensor transfer, output mV at the ends of its pressure range
+        double sensor_mv_min = 132;
+        double sensor_mv_max = 3168;
+        double sensor_mbar_min = 200;
+        double sensor_mbar_max = 2500;
+        /// Gaussian noise of the ADC itself, rms counts; it dithers the
+        /// quantiser, so averaging can resolve below one count
+        double adc_noise_lsb = 0.7;
+
+        uint32_t seed = 1;
+    };
+
+    explicit EngineVacuum(const Config &config);
+
+    /// @brief Engine speed at time t_us
+    double rpm(uint64_t t_us) const;
+
+    /// @brief Crank angle since t = 0, in degrees, not wrapped
+    double crank_deg(uint64_t t_us) const;
+
+    /// @brief Noise-free absolute pressure at the channel's sensor
+    double pressure_mbar(unsigned channel, uint64_t t_us) const;
+
+    /// @brief Sensor output in mV, noise and ignition ringing included
+    uint16_t millivolts(unsigned channel, uint64_t t_us);
+
+    /// @brief ADC counts of the sensor output, 12 bits with 3.3 V reference
+    uint16_t counts(unsigned channel, uint64_t t_us);
+
+    /// @brief hal::host::AnalogSource, context is the EngineVacuum
+    static uint16_t analog_source(unsigned input, uint64_t t_us,
+                                  void *context);
+
+    const Config &config() const { return _config; }
+
+private:
+    double pulse(double phase_deg) const;
+    double spark(double crank, double rpm) const;
+    double gaussian();
+    double sensor_mv(unsigned channel, uint64_t t_us);
+
+    Config _config;
+    double _intake_deg[MAX_CYLINDERS];  // intake opening, per cylinder
+    double _firing_deg[MAX_CYLINDERS];  // ignition, per firing slot
+    uint32_t _rng;
+};
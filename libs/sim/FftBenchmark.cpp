@@ -0,0 +1,133 @@
+#include "FftBenchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+#include "FixedFft.h"
+#include "SpectrumAnalysis.h"
+
+namespace {
+
+// a Q15 FFT keeps roughly 1 bit per stage less than its input
+constexpr double MIN_SNR_DB = 50.0;
+constexpr double MAX_AMPLITUDE_ERROR = 0.02;
+constexpr int RUNS = 200;
+
+uint32_t s_seed = 12345;
+
+double uniform() {
+    s_seed = s_seed * 1664525U + 1013904223U;
+    return (s_seed >> 8) / 16777216.0;
+}
+
+std::vector<std::complex<double>> reference_dft(const std::vector<double> &x) {
+    const size_t n = x.size();
+    std::vector<std::complex<double>> out(n);
+    for (size_t k = 0; k < n; k++) {
+        std::complex<double> sum = 0;
+        for (size_t i = 0; i < n; i++) {
+            const double angle = -2 * M_PI * (double)((k * i) % n) / n;
+            sum += x[i] * std::polar(1.0, angle);
+        }
+        out[k] = sum / (double)n;
+    }
+    return out;
+}
+
+template <unsigned N>
+bool check_transform() {
+    // three tones and white noise, peak about 0.9 of full scale
+    std::vector<double> x(N);
+    int16_t re[N];
+    int16_t im[N];
+    for (unsigned i = 0; i < N; i++) {
+        const double t = (double)i / N;
+        const double v = 0.45 * std::sin(2 * M_PI * 7.3 * t) +
+                         0.25 * std::sin(2 * M_PI * 31 * t + 1) +
+                         0.1 * std::cos(2 * M_PI * 101.6 * t) +
+                         0.1 * (uniform() - 0.5);
+        re[i] = (int16_t)std::lround(v * 32767);
+        im[i] = 0;
+        x[i] = re[i];
+    }
+    const auto ref = reference_dft(x);
+
+    int16_t work_re[N];
+    int16_t work_im[N];
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; run++) {
+        for (unsigned i = 0; i < N; i++) {
+            work_re[i] = re[i];
+            work_im[i] = im[i];
+        }
+        FixedFft<N>::forward(work_re, work_im);
+    }
+    const double us =
+        std::chrono::duration<double, std::micro>(
+            std::chrono::steady_clock::now() - start)
+            .count() /
+        RUNS;
+
+    double signal = 0, noise = 0, worst = 0;
+    for (unsigned k = 0; k < N; k++) {
+        const std::complex<double> got(work_re[k], work_im[k]);
+        const double err = std::abs(got - ref[k]);
+        signal += std::norm(ref[k]);
+        noise += err * err;
+        if (err > worst) worst = err;
+    }
+    const double snr = 10 * std::log10(signal / noise);
+    const bool ok = snr >= MIN_SNR_DB;
+    printf("FFT %4u: SNR %5.1f dB, worst bin error %.2f LSB, %7.1f us "
+           "per transform on the host  %s\n",
+           N, snr, worst, us, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+template <unsigned N>
+bool check_analysis() {
+    bool ok = true;
+    // 12-bit counts around mid-scale, like the capture
+    const double bins[] = {9.0, 20.4, 57.75};
+    const double amplitudes[] = {300.0, 800.0, 1500.0};
+    for (double bin : bins) {
+        for (double amplitude : amplitudes) {
+            int16_t re[N];
+            int16_t im[N];
+            for (unsigned i = 0; i < N; i++) {
+                re[i] = (int16_t)std::lround(
+                    2048 + amplitude * std::sin(2 * M_PI * bin * i / N));
+            }
+            const SpectrumReport report = analyze_spectrum<N>(re, im, 0, 1);
+            const double found = report.fundamental_q8 / 256.0;
+            const double error = report.amplitude[0] / amplitude - 1;
+            const bool good = std::fabs(found - bin) < 1.0 &&
+                              std::fabs(error) < MAX_AMPLITUDE_ERROR;
+            if (!good) {
+                printf("spectrum %4u: tone at bin %.2f amplitude %.0f found "
+                       "at %.2f amplitude %u  FAIL\n",
+                       N, bin, amplitude, found, report.amplitude[0]);
+            }
+            ok &= good;
+        }
+    }
+    if (ok) printf("spectrum %4u: tones found, amplitudes within 2%%  ok\n", N);
+    return ok;
+}
+
+}  // namespace
+
+int fft_benchmark() {
+    bool ok = true;
+    ok &= check_transform<256>();
+    ok &= check_transform<512>();
+    ok &= check_transform<1024>();
+    ok &= check_analysis<256>();
+    ok &= check_analysis<512>();
+    ok &= check_analysis<1024>();
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+/// @brief Accuracy and speed of FixedFft and analyze_spectrum() on the host
+/// @details For 256, 512 and 1024 points: multi-tone plus noise inputs are
+/// transformed by FixedFft and by a double precision DFT, the report gives
+/// the SNR of the fixed point result and its worst bin error. Pure tones of
+/// known amplitude then go through analyze_spectrum(), which has to find
+/// them within a bin and their amplitude within 2%.
+/// @return 0 if every check passed, 1 otherwise
+int fft_benchmark();
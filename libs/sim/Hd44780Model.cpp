@@ -0,0 +1,231 @@
+#include "Hd44780Model.h"
+
+#include <cstring>
+
+namespace {
+
+// PCF8574 port bits
+constexpr uint8_t PIN_RS = 0x01;
+constexpr uint8_t PIN_RW = 0x02;
+constexpr uint8_t PIN_E = 0x04;
+constexpr uint8_t DATA_MASK = 0xF0;
+
+// execution times at fosc = 270 kHz
+constexpr uint64_t EXEC_NS = 37000U;
+constexpr uint64_t EXEC_DATA_NS = EXEC_NS + 4000U;  // + address update
+constexpr uint64_t EXEC_HOME_NS = 1520000U;
+
+constexpr uint8_t LINE_LENGTH = 40;
+constexpr uint8_t ROW_OFFSETS[] = {0x00, 0x40, 0x14, 0x54};
+
+}  // namespace
+
+Hd44780Model::Hd44780Model(uint8_t cols, uint8_t rows)
+    : _cols(cols), _rows(rows) {
+    // DDRAM powers up undefined, blanks are as good as anything
+    memset(_ddram, ' ', sizeof(_ddram));
+}
+
+bool Hd44780Model::write(const uint8_t *src, size_t len, uint64_t start_us,
+                         uint32_t byte_ns) {
+    const uint64_t start_ns = start_us * 1000U;
+    // each byte appears on the port when its acknowledge is clocked in
+    for (size_t i = 0; i < len; i++) {
+        latch(src[i], start_ns + (i + 2) * byte_ns);
+    }
+    account(len, start_ns, byte_ns);
+    return true;
+}
+
+bool Hd44780Model::read(uint8_t *dst, size_t len, uint64_t start_us,
+                        uint32_t byte_ns) {
+    // Quasi-bidirectional port: an output latched high reads back whatever
+    // drives the pin, the controller drives D4-D7 while R/W and E are high
+    uint8_t pins = _latch;
+    if ((_latch & (PIN_RW | PIN_E)) == (PIN_RW | PIN_E)) {
+        const uint8_t nibble =
+            _lowNibble ? (uint8_t)(_readByte << 4) : (_readByte & DATA_MASK);
+        pins = (_latch & ~DATA_MASK) | (_latch & nibble & DATA_MASK);
+    }
+    for (size_t i = 0; i < len; i++) {
+        dst[i] = pins;
+    }
+    account(len, start_us * 1000U, byte_ns);
+    return true;
+}
+
+void Hd44780Model::account(size_t len, uint64_t start_ns, uint32_t byte_ns) {
+    const uint64_t end_ns = start_ns + (len + 1) * byte_ns;
+    if (!_frame.i2cTransactions) _frameStartNs = start_ns;
+    _frameEndNs = end_ns;
+    _frame.i2cBytes += len;
+    _frame.i2cTransactions++;
+    _frame.busNs += end_ns - start_ns;
+    _frame.wallNs = _frameEndNs - _frameStartNs;
+}
+
+void Hd44780Model::latch(uint8_t value, uint64_t t_ns) {
+    const uint8_t prev = _latch;
+    _latch = value;
+    const bool rising = !(prev & PIN_E) && (value & PIN_E);
+    const bool falling = (prev & PIN_E) && !(value & PIN_E);
+
+    if (rising && (value & PIN_RW) && !_lowNibble) {
+        // the whole byte is sampled at the start of the first read cycle
+        _readByte = readByte(value & PIN_RS, t_ns);
+    }
+    if (!falling) return;
+
+    // data is taken from the port state while E was high
+    const bool rs = prev & PIN_RS;
+    const uint8_t nibble = prev & DATA_MASK;
+    if (prev & PIN_RW) {
+        if (_eightBit) {
+            if (rs) step();
+        } else if (_lowNibble) {
+            _lowNibble = false;
+            if (rs) step();
+        } else {
+            _lowNibble = true;
+        }
+        return;
+    }
+    if (_eightBit) {
+        // D0-D3 are not wired, they read as 0
+        execute(nibble, rs, t_ns);
+    } else if (!_lowNibble) {
+        _high = nibble;
+        _lowNibble = true;
+    } else {
+        _lowNibble = false;
+        execute(_high | (nibble >> 4), rs, t_ns);
+    }
+}
+
+uint8_t Hd44780Model::readByte(bool rs, uint64_t t_ns) {
+    if (rs) {
+        return _cgramSelected ? _cgram[_ac & 0x3F] : _ddram[_ac & 0x7F];
+    }
+    return (t_ns < _busyUntilNs ? 0x80 : 0x00) | (_ac & 0x7F);
+}
+
+void Hd44780Model::execute(uint8_t value, bool rs, uint64_t t_ns) {
+    if (t_ns < _busyUntilNs) {
+        _frame.busyViolations++;
+    }
+    if (!rs) {
+        instruction(value, t_ns);
+        return;
+    }
+    _frame.dataWrites++;
+    _busyUntilNs = t_ns + EXEC_DATA_NS;
+    if (_cgramSelected) {
+        _cgram[_ac & 0x3F] = value & 0x1F;
+    } else {
+        _ddram[_ac & 0x7F] = value;
+        if (_entry & 0x01) {
+            // display shift follows the cursor direction
+            _shift = (_shift + ((_entry & 0x02) ? 1 : LINE_LENGTH - 1)) %
+                     LINE_LENGTH;
+        }
+    }
+    step();
+}
+
+void Hd44780Model::instruction(uint8_t value, uint64_t t_ns) {
+    _frame.instructions++;
+    uint64_t exec_ns = EXEC_NS;
+    if (value & 0x80) {  // set DDRAM address
+        _ac = value & 0x7F;
+        _cgramSelected = false;
+    } else if (value & 0x40) {  // set CGRAM address
+        _ac = value & 0x3F;
+        _cgramSelected = true;
+    } else if (value & 0x20) {  // function set
+        _eightBit = value & 0x10;
+        _twoLine = value & 0x08;
+        _lowNibble = false;
+    } else if (value & 0x10) {  // cursor or display shift
+        const bool right = value & 0x04;
+        if (value & 0x08) {
+            _shift = (_shift + (right ? LINE_LENGTH - 1 : 1)) % LINE_LENGTH;
+        } else {
+            const uint8_t entry = _entry;
+            _entry = right ? 0x02 : 0x00;
+            step();
+            _entry = entry;
+        }
+    } else if (value & 0x08) {  // display on/off control
+        _control = value & 0x07;
+    } else if (value & 0x04) {  // entry mode set
+        _entry = value & 0x03;
+    } else if (value & 0x02) {  // return home
+        _ac = 0;
+        _shift = 0;
+        _cgramSelected = false;
+        exec_ns = EXEC_HOME_NS;
+    } else if (value & 0x01) {  // clear display
+        memset(_ddram, ' ', sizeof(_ddram));
+        _ac = 0;
+        _shift = 0;
+        _cgramSelected = false;
+        _entry |= 0x02;
+        exec_ns = EXEC_HOME_NS;
+    }
+    _busyUntilNs = t_ns + exec_ns;
+}
+
+// Address counter after a data access, in the current entry direction
+void Hd44780Model::step() {
+    const bool up = _entry & 0x02;
+    if (_cgramSelected) {
+        _ac = (_ac + (up ? 1 : -1)) & 0x3F;
+    } else if (!_twoLine) {
+        _ac = up ? (_ac >= 0x4F ? 0x00 : _ac + 1)
+                 : (_ac == 0x00 ? 0x4F : _ac - 1);
+    } else if (up) {
+        _ac = _ac == 0x27 ? 0x40 : _ac == 0x67 ? 0x00 : _ac + 1;
+    } else {
+        _ac = _ac == 0x40 ? 0x27 : _ac == 0x00 ? 0x67 : _ac - 1;
+    }
+}
+
+uint8_t Hd44780Model::cell(uint8_t row, uint8_t col) const {
+    const uint8_t offset = ROW_OFFSETS[row & 3];
+    if (!_twoLine) {
+        return _ddram[(offset + col + _shift) % (2 * LINE_LENGTH)];
+    }
+    const uint8_t base = offset & 0x40;
+    const uint8_t pos = (offset - base + col + _shift) % LINE_LENGTH;
+    return _ddram[base + pos];
+}
+
+std::string Hd44780Model::text(uint8_t row) const {
+    std::string line(_cols, ' ');
+    for (uint8_t col = 0; col < _cols; col++) {
+        const uint8_t c = cell(row, col);
+        if (c < 0x10) {
+            line[col] = '0' + (c & 7);
+        } else if (c == 0xFF) {
+            line[col] = '#';
+        } else if (c >= 0x20 && c < 0x80) {
+            line[col] = c;
+        } else {
+            line[col] = '?';
+        }
+    }
+    return line;
+}
+
+Hd44780Model::FrameStats Hd44780Model::takeFrame() {
+    const FrameStats frame = _frame;
+    _totals.i2cBytes += frame.i2cBytes;
+    _totals.i2cTransactions += frame.i2cTransactions;
+    _totals.instructions += frame.instructions;
+    _totals.dataWrites += frame.dataWrites;
+    _totals.busyViolations += frame.busyViolations;
+    _totals.busNs += frame.busNs;
+    _totals.wallNs += frame.wallNs;
+    _frame = {};
+    return frame;
+}
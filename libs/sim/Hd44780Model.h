@@ -0,0 +1,88 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "HalHost.h"
+
+/// @brief Host model of an HD44780 behind a PCF8574 I2C backpack.
+/// @details Decodes the expander byte stream bit by bit: P0 = RS, P1 = R/W,
+/// P2 = E, P3 = backlight, P4-P7 = D4-D7. The controller latches on the
+/// falling edge of E, starts in 8-bit mode and follows the datasheet
+/// initialisation by instruction into 4-bit mode. Instructions, DDRAM and
+/// CGRAM addressing, entry modes, display/cursor shift and reads (busy
+/// flag, address counter and data) are modelled. Execution times are the
+/// datasheet ones at 270 kHz; an access while the controller is still busy
+/// is counted as a violation and then executed anyway, so the screen stays
+/// readable.
+class Hd44780Model : public hal::host::I2cDevice {
+public:
+    /// @brief Bus and controller activity since the previous takeFrame()
+    struct FrameStats {
+        uint32_t i2cBytes;         // data bytes, address bytes not counted
+        uint32_t i2cTransactions;  // start/address/stop sequences
+        uint32_t instructions;     // instructions executed
+        uint32_t dataWrites;       // DDRAM/CGRAM bytes written
+        uint32_t busyViolations;   // accesses while the controller was busy
+        uint64_t busNs;            // time the bus was busy with this device
+        uint64_t wallNs;           // first byte to end of the last one
+    };
+
+    Hd44780Model(uint8_t cols, uint8_t rows);
+
+    bool write(const uint8_t *src, size_t len, uint64_t start_us,
+               uint32_t byte_ns) override;
+    bool read(uint8_t *dst, size_t len, uint64_t start_us,
+              uint32_t byte_ns) override;
+
+    /// @brief Visible character codes of one display row
+    uint8_t cell(uint8_t row, uint8_t col) const;
+
+    /// @brief One display row as text, CGRAM characters shown as '0'-'7'
+    std::string text(uint8_t row) const;
+
+    /// @brief Pattern rows of a CGRAM character
+    const uint8_t *cgram(uint8_t slot) const { return &_cgram[(slot & 7) * 8]; }
+
+    uint8_t cols() const { return _cols; }
+    uint8_t rows() const { return _rows; }
+    bool displayOn() const { return _control & 0x04; }
+    bool backlight() const { return _latch & 0x08; }
+    uint8_t addressCounter() const { return _ac; }
+
+    /// @brief Statistics since the previous call, then start a new frame
+    FrameStats takeFrame();
+
+    /// @brief Totals since construction
+    const FrameStats &totals() const { return _totals; }
+
+private:
+    void latch(uint8_t value, uint64_t t_ns);
+    void execute(uint8_t value, bool rs, uint64_t t_ns);
+    void instruction(uint8_t value, uint64_t t_ns);
+    uint8_t readByte(bool rs, uint64_t t_ns);
+    void step();
+    void account(size_t len, uint64_t start_ns, uint32_t byte_ns);
+
+    uint8_t _cols;
+    uint8_t _rows;
+    uint8_t _latch = 0xFF;  // PCF8574 powers up with all outputs high
+    bool _eightBit = true;
+    bool _lowNibble = false;  // 4-bit mode: next E cycle is the low nibble
+    uint8_t _high = 0;
+    uint8_t _readByte = 0;
+    bool _twoLine = false;
+    bool _cgramSelected = false;
+    uint8_t _ac = 0;
+    int8_t _shift = 0;       // display shift, 0-39
+    uint8_t _entry = 0x02;   // increment, no shift
+    uint8_t _control = 0;    // display, cursor and blink off
+    uint64_t _busyUntilNs = 0;
+    uint8_t _ddram[128];
+    uint8_t _cgram[64] = {};
+    FrameStats _frame = {};
+    FrameStats _totals = {};
+    uint64_t _frameStartNs = 0;
+    uint64_t _frameEndNs = 0;
+};
@@ -0,0 +1,155 @@
+#include "LcdTxBenchmark.h"
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "Hd44780Model.h"
+#include "HalHost.h"
+#include "LcdTxQueue.h"
+#include "LiquidCrystal_I2C.h"
+
+namespace {
+
+constexpr uint8_t ADDRESS = 0x3F;
+constexpr uint8_t COLS = 16;
+constexpr uint8_t ROWS = 2;
+constexpr unsigned GLYPH_CELLS = 4;
+constexpr unsigned PATTERNS = 10;
+constexpr unsigned FRAMES = 30;
+
+// What the shadow buffer holds: text, or the pattern of a glyph cell
+struct Screen {
+    char text[ROWS][COLS + 1];
+    int8_t glyph[ROWS][COLS];
+};
+
+void pattern(unsigned n, uint8_t rows[8]) {
+    for (unsigned r = 0; r < 8; r++) {
+        rows[r] = (uint8_t)((n + 1) * (r + 3) ^ (r << 2)) & 0x1F;
+    }
+    rows[0] = (uint8_t)(n + 1);
+}
+
+// Row 0 text, row 1 four glyphs out of PATTERNS then text: every frame
+// requests one glyph which the previous one did not show
+void draw(LiquidCrystal_I2C &lcd, unsigned n, Screen &screen) {
+    memset(&screen, 0, sizeof(screen));
+    memset(screen.glyph, -1, sizeof(screen.glyph));
+    snprintf(screen.text[0], COLS + 1, "frame %-10u", n);
+    lcd.setCursor(0, 0);
+    lcd.print(screen.text[0]);
+    lcd.setCursor(0, 1);
+    for (unsigned i = 0; i < GLYPH_CELLS; i++) {
+        uint8_t rows[8];
+        screen.glyph[1][i] = (int8_t)((n + i) % PATTERNS);
+        pattern(screen.glyph[1][i], rows);
+        lcd.writeGlyph(rows);
+        screen.text[1][i] = '?';
+    }
+    snprintf(screen.text[1] + GLYPH_CELLS, COLS + 1 - GLYPH_CELLS, "%12u",
+             n * 7919U);
+    lcd.print(screen.text[1] + GLYPH_CELLS);
+}
+
+bool matches(const Hd44780Model &model, const Screen &screen) {
+    for (uint8_t row = 0; row < ROWS; row++) {
+        for (uint8_t col = 0; col < COLS; col++) {
+            const uint8_t cell = model.cell(row, col);
+            if (screen.glyph[row][col] < 0) {
+                if (cell != (uint8_t)screen.text[row][col]) return false;
+                continue;
+            }
+            uint8_t rows[8];
+            pattern(screen.glyph[row][col], rows);
+            if (cell >= 8 || memcmp(model.cgram(cell), rows, 8)) return false;
+        }
+    }
+    return true;
+}
+
+bool report(const char *what, bool ok) {
+    printf("LCD queue: %s  %s\n", what, ok ? "ok" : "FAIL");
+    return ok;
+}
+
+}  // namespace
+
+int lcd_tx_benchmark() {
+    static LcdTxQueue s_queue;
+    Hd44780Model model(COLS, ROWS);
+    LiquidCrystal_I2C lcd(ADDRESS, COLS, ROWS);
+    hal::host::attach_i2c(ADDRESS, &model);
+    lcd.init();
+    lcd.backlight();
+    if (!lcd.setTxQueue(&s_queue)) {
+        hal::host::attach_i2c(ADDRESS, nullptr);
+        report("setTxQueue() failed", false);
+        return 1;
+    }
+    lcd.setBuffered(true);
+
+    Screen screen;
+    bool ok = true;
+    bool frames = true;
+    unsigned n = 0;
+    for (; n < FRAMES; n++) {
+        draw(lcd, n, screen);
+        lcd.flush();
+        s_queue.drain();
+        frames &= matches(model, screen);
+    }
+    ok &= report("buffered frames with glyph uploads on the screen",
+                 frames && s_queue.stats().overruns == 0);
+
+    // the frame and its glyph upload are dropped, the next one repaints
+    s_queue.setForcedFull(true);
+    draw(lcd, n++, screen);
+    lcd.flush();
+    s_queue.setForcedFull(false);
+    bool dropped = s_queue.stats().overruns > 0 && !matches(model, screen);
+    draw(lcd, n++, screen);
+    lcd.flush();
+    s_queue.drain();
+    ok &= report("frame dropped on a full queue repainted, glyph uploaded "
+                 "again",
+                 dropped && matches(model, screen));
+
+    // a lone expander write is dropped, the next flush repaints with it
+    const uint32_t overruns = s_queue.stats().overruns;
+    s_queue.setForcedFull(true);
+    lcd.noBacklight();
+    s_queue.setForcedFull(false);
+    dropped = s_queue.stats().overruns > overruns && model.backlight();
+    lcd.flush();
+    s_queue.drain();
+    ok &= report("dropped backlight write restored by the repaint",
+                 dropped && !model.backlight() && matches(model, screen));
+    lcd.backlight();
+
+    // unbuffered, every byte is a transfer of its own
+    lcd.setBuffered(false);
+    lcd.flush();
+    lcd.setCursor(0, 0);
+    lcd.write('u');
+    lcd.write('n');
+    lcd.flush();
+    s_queue.drain();
+    screen.text[0][0] = 'u';
+    screen.text[0][1] = 'n';
+    ok &= report("unbuffered writes counted once",
+                 lcd.frameStats().lcdBytes == 3 && matches(model, screen));
+
+    // clear() settles in the queue, the frame behind it waits
+    lcd.setBuffered(true);
+    draw(lcd, n++, screen);
+    lcd.flush();
+    s_queue.drain();
+    ok &= report("clear() settled without a busy violation",
+                 model.totals().busyViolations == 0 &&
+                     matches(model, screen));
+
+    lcd.setTxQueue(nullptr);
+    hal::host::attach_i2c(ADDRESS, nullptr);
+    return ok ? 0 : 1;
+}
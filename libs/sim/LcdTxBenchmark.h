@@ -0,0 +1,12 @@
+#pragma once
+
+/// @brief LiquidCrystal_I2C on the host LcdTxQueue, into an Hd44780Model
+/// @details Buffered frames of text and cached glyphs go through the queue
+/// and the model's screen and CGRAM have to match what was drawn. Then one
+/// frame, with a glyph upload and a backlight write, is drawn while the
+/// queue is forced full: every transfer is dropped, and the next frame has
+/// to repaint the screen, upload the glyph again and restore the
+/// backlight. Unbuffered single writes have to be counted once each, and
+/// clear() has to settle without a busy violation.
+/// @return 0 if every check passed, 1 otherwise
+int lcd_tx_benchmark();
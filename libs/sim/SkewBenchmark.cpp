@@ -0,0 +1,92 @@
+#include "SkewBenchmark.h"
+
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+
+#include "EngineVacuum.h"
+#include "SkewAligner.h"
+
+namespace {
+
+constexpr unsigned CHANNEL_RATE = 5000;  // samples/s of one channel
+constexpr uint64_t PERIOD_US = 1000000U / CHANNEL_RATE;
+constexpr uint64_t SKEW_US = PERIOD_US / 2;  // one conversion of two
+constexpr double SECONDS = 2.0;
+// What is left is quantisation, 0.25 mbar rms of a pair, and the
+// interpolation error at the kink where the synthetic pulse starts
+constexpr double MIN_IMPROVEMENT = 4.0;
+constexpr double QUANTISATION_MBAR = 1.0;
+
+struct PairError {
+    double rms;
+    double peak;
+};
+
+struct Accumulator {
+    double squares = 0;
+    double peak = 0;
+    unsigned count = 0;
+
+    void add(double diff) {
+        squares += diff * diff;
+        if (std::fabs(diff) > peak) peak = std::fabs(diff);
+        count++;
+    }
+
+    PairError result(double scale) const {
+        return {scale * std::sqrt(squares / count), scale * peak};
+    }
+};
+
+bool check_speed(double rpm) {
+    EngineVacuum::Config config;
+    config.rpm = rpm;
+    config.channel_cylinder[1] = config.channel_cylinder[0];
+    config.noise_mbar = 0;
+    config.adc_noise_lsb = 0;
+    config.spark_mv = 0;
+    EngineVacuum engine(config);
+    const double mbar_per_count =
+        3300.0 / 4096 * (config.sensor_mbar_max - config.sensor_mbar_min) /
+        (config.sensor_mv_max - config.sensor_mv_min);
+
+    SkewAligner<4, 2, (uint32_t)(SKEW_US * 65536U / PERIOD_US)> aligner;
+    Accumulator raw, aligned;
+    const unsigned samples = (unsigned)(SECONDS * CHANNEL_RATE);
+    for (unsigned n = 0; n < samples; n++) {
+        const uint64_t t_us = n * PERIOD_US;
+        const uint16_t a0 = engine.counts(0, t_us);
+        const uint16_t a1 = engine.counts(1, t_us + SKEW_US);
+        // both come out one sample late, as of t_us - PERIOD_US
+        const uint16_t in[2] = {a0, a1};
+        uint16_t out[2];
+        aligner.push(in, out);
+        const uint16_t b0 = out[0];
+        const uint16_t b1 = out[1];
+        // the delay lines start primed, skip their first window anyway
+        if (n < 4) continue;
+        raw.add((double)a1 - a0);
+        aligned.add((double)b1 - b0);
+    }
+
+    const PairError before = raw.result(mbar_per_count);
+    const PairError after = aligned.result(mbar_per_count);
+    const bool ok = after.rms * MIN_IMPROVEMENT <= before.rms + QUANTISATION_MBAR;
+    printf("skew %5.0f rpm: V2-V1 raw %5.2f mbar rms %4.1f peak, aligned "
+           "%4.2f rms %4.1f peak  %s\n",
+           rpm, before.rms, before.peak, after.rms, after.peak,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+}  // namespace
+
+int skew_benchmark() {
+    static const double c_SPEEDS[] = {800, 1500, 3000, 6000, 10000};
+    bool ok = true;
+    for (double rpm : c_SPEEDS) {
+        ok &= check_speed(rpm);
+    }
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,11 @@
+#pragma once
+
+/// @brief Inter-channel skew of the round robin, and its compensation
+/// @details Both channels watch the same runner of a noise-free
+/// EngineVacuum and are sampled like the ADC does at 10 kS/s: channel 2
+/// one conversion, 100 us, after channel 1. The difference of every pair
+/// should be zero. The report gives its rms and peak in mbar at several
+/// engine speeds, raw and with channel 2 interpolated onto channel 1's
+/// time base by SkewAligner, which has to remove most of it.
+/// @return 0 if every check passed, 1 otherwise
+int skew_benchmark();
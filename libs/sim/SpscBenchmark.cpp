@@ -0,0 +1,108 @@
+#include "SpscBenchmark.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <thread>
+
+#include "SpscQueue.h"
+
+namespace {
+
+constexpr uint32_t ITEMS = 500000;
+// the dropping producer pauses after this many pushes, so both drops and
+// deliveries happen
+constexpr uint32_t BURST = 48;
+
+// big enough to tear if a slot were read while it is written
+struct Item {
+    uint32_t sequence;
+    uint32_t payload[3];
+};
+
+typedef SpscQueue<Item, 32> Queue;
+
+// Give the other thread the core, the host may have only one and yield()
+// does not hand it over there
+void wait() { std::this_thread::sleep_for(std::chrono::microseconds(1)); }
+
+Item make_item(uint32_t sequence) {
+    return {sequence,
+            {sequence * 2654435761U, ~sequence, sequence ^ 0x5A5A5A5AU}};
+}
+
+bool intact(const Item &item) {
+    const Item expected = make_item(item.sequence);
+    return item.payload[0] == expected.payload[0] &&
+           item.payload[1] == expected.payload[1] &&
+           item.payload[2] == expected.payload[2];
+}
+
+struct Result {
+    uint32_t received = 0;
+    uint32_t out_of_order = 0;
+    uint32_t torn = 0;
+};
+
+// Pop until the producer is done and the queue is empty
+void consume(Queue &queue, const std::atomic<bool> &done, Result &result) {
+    uint32_t next = 0;
+    Item item;
+    for (;;) {
+        if (!queue.pop(item)) {
+            if (done.load(std::memory_order_acquire) && queue.empty()) break;
+            wait();
+            continue;
+        }
+        if (item.sequence < next) result.out_of_order++;
+        if (!intact(item)) result.torn++;
+        next = item.sequence + 1;
+        result.received++;
+    }
+}
+
+bool check(bool retry) {
+    Queue queue;
+    std::atomic<bool> done{false};
+    Result result;
+    uint32_t failed = 0;
+
+    const auto start = std::chrono::steady_clock::now();
+    std::thread consumer(consume, std::ref(queue), std::cref(done),
+                         std::ref(result));
+    for (uint32_t n = 0; n < ITEMS; n++) {
+        const Item item = make_item(n);
+        while (!queue.push(item)) {
+            failed++;
+            if (!retry) break;
+            wait();
+        }
+        if (!retry && n % BURST == BURST - 1) wait();
+    }
+    done.store(true, std::memory_order_release);
+    consumer.join();
+    const double ns = std::chrono::duration<double, std::nano>(
+                          std::chrono::steady_clock::now() - start)
+                          .count() /
+                      ITEMS;
+
+    const uint32_t expected = retry ? ITEMS : ITEMS - failed;
+    const bool ok = result.received == expected && !result.out_of_order &&
+                    !result.torn && queue.overruns() == failed;
+    printf("SPSC %s: %u of %u items received, %u out of order, %u torn, "
+           "%u overruns of %u failed pushes, %.0f ns per item  %s\n",
+           retry ? "retrying" : "dropping", result.received, ITEMS,
+           result.out_of_order, result.torn, queue.overruns(), failed, ns,
+           ok ? "ok" : "FAIL");
+    return ok;
+}
+
+}  // namespace
+
+int spsc_benchmark() {
+    bool ok = true;
+    ok &= check(true);
+    ok &= check(false);
+    return ok ? 0 : 1;
+}
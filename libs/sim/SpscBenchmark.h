@@ -0,0 +1,11 @@
+#pragma once
+
+/// @brief SpscQueue hammered from two threads
+/// @details A producer thread pushes numbered items whose payload is
+/// derived from the number, a consumer thread pops them. First the
+/// producer retries a full queue, so every item has to arrive, in order.
+/// Then it drops on full, like the acquisition interrupt: what arrives has
+/// to be in order and intact, and the overrun count has to match the
+/// pushes which failed.
+/// @return 0 if every check passed, 1 otherwise
+int spsc_benchmark();
@@ -0,0 +1,130 @@
+#include "UnitsBenchmark.h"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+
+#include "PressureUnits.h"
+
+namespace {
+
+constexpr int32_t VREF_MV = 3300;
+constexpr int32_t FULL_SCALE = 4096;
+constexpr double MBAR_PER_MMHG = 1.33322368;
+constexpr double MBAR_PER_INHG = 33.8638866;
+constexpr int RUNS = 2000;
+// Q16 results have to stay within a few LSB of the exact transfer function,
+// in every unit
+constexpr double MAX_FIXED_ERROR = 0.001;
+
+struct Sensor {
+    int32_t mv_min, mv_max, mbar_min, mbar_max;
+};
+
+struct Reading {
+    double mbar, mmhg, kpa, inhg;
+};
+
+long map(long x, long in_min, long in_max, long out_min, long out_max) {
+    return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
+}
+
+Reading exact(const Sensor &s, int32_t counts) {
+    const double mv = (double)counts * VREF_MV / FULL_SCALE;
+    const double mbar = (mv - s.mv_min) * (s.mbar_max - s.mbar_min) /
+                            (s.mv_max - s.mv_min) +
+                        s.mbar_min;
+    return {mbar, mbar / MBAR_PER_MMHG, mbar / 10, mbar / MBAR_PER_INHG};
+}
+
+// as the firmware did before the units layer
+Reading legacy(const Sensor &s, int32_t counts) {
+    const long mv = counts * VREF_MV / FULL_SCALE;
+    const long mbar = map(mv, s.mv_min, s.mv_max, s.mbar_min, s.mbar_max);
+    return {(double)mbar, std::floor(mbar / 1.33322), mbar / 10.0,
+            mbar / MBAR_PER_INHG};
+}
+
+Reading fixed(const units::PressureMap &to_mbar, int32_t counts) {
+    const units::Pressure mbar = to_mbar(counts);
+    const double one = units::Pressure::ONE;
+    return {mbar.raw() / one, units::to_mmhg(mbar).raw() / one,
+            units::to_kpa(mbar).raw() / one,
+            units::to_inhg(mbar).raw() / one};
+}
+
+struct Worst {
+    double mbar = 0, mmhg = 0, kpa = 0, inhg = 0;
+
+    void add(const Reading &got, const Reading &ref) {
+        mbar = std::fmax(mbar, std::fabs(got.mbar - ref.mbar));
+        mmhg = std::fmax(mmhg, std::fabs(got.mmhg - ref.mmhg));
+        kpa = std::fmax(kpa, std::fabs(got.kpa - ref.kpa));
+        inhg = std::fmax(inhg, std::fabs(got.inhg - ref.inhg));
+    }
+};
+
+// ns per conversion of all four units, the sum keeps the work alive
+template <typename Convert>
+double time_ns(Convert convert, int64_t &sink) {
+    const auto start = std::chrono::steady_clock::now();
+    for (int run = 0; run < RUNS; run++) {
+        for (int32_t counts = 0; counts < FULL_SCALE; counts++) {
+            sink += convert(counts);
+        }
+    }
+    return std::chrono::duration<double, std::nano>(
+               std::chrono::steady_clock::now() - start)
+               .count() /
+           ((double)RUNS * FULL_SCALE);
+}
+
+}  // namespace
+
+int units_benchmark(int32_t mv_min, int32_t mv_max, int32_t mbar_min,
+                    int32_t mbar_max) {
+    const Sensor s = {mv_min, mv_max, mbar_min, mbar_max};
+    const units::PressureMap to_mbar = units::sensor_counts_to_mbar(
+        VREF_MV, FULL_SCALE, mv_min, mv_max, mbar_min, mbar_max);
+
+    Worst old_error, new_error;
+    for (int32_t counts = 0; counts < FULL_SCALE; counts++) {
+        const Reading ref = exact(s, counts);
+        old_error.add(legacy(s, counts), ref);
+        new_error.add(fixed(to_mbar, counts), ref);
+    }
+
+    int64_t sink = 0;
+    volatile int32_t offset = 0;  // keeps the loops from being folded
+    const double old_ns = time_ns(
+        [&](int32_t counts) {
+            const long mv = (counts + offset) * VREF_MV / FULL_SCALE;
+            const long mbar =
+                map(mv, s.mv_min, s.mv_max, s.mbar_min, s.mbar_max);
+            return (int64_t)(mbar + std::floor(mbar / 1.33322) +
+                             mbar / 10.0 + mbar / MBAR_PER_INHG);
+        },
+        sink);
+    const double new_ns = time_ns(
+        [&](int32_t counts) {
+            const units::Pressure mbar = to_mbar(counts + offset);
+            return (int64_t)mbar.raw() + units::to_mmhg(mbar).raw() +
+                   units::to_kpa(mbar).raw() + units::to_inhg(mbar).raw();
+        },
+        sink);
+
+    const bool ok =
+        new_error.mbar <= MAX_FIXED_ERROR && new_error.mmhg <= MAX_FIXED_ERROR &&
+        new_error.kpa <= MAX_FIXED_ERROR && new_error.inhg <= MAX_FIXED_ERROR;
+    printf("units map()/double: worst error %.5f mbar %.5f mmHg %.5f kPa "
+           "%.5f inHg, %.1f ns per conversion on the host\n",
+           old_error.mbar, old_error.mmhg, old_error.kpa, old_error.inhg,
+           old_ns);
+    printf("units Q16:          worst error %.5f mbar %.5f mmHg %.5f kPa "
+           "%.5f inHg, %.1f ns per conversion on the host  %s\n",
+           new_error.mbar, new_error.mmhg, new_error.kpa, new_error.inhg,
+           new_ns, ok ? "ok" : "FAIL");
+    static volatile int64_t s_sink;
+    s_sink += sink;
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,18 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Fixed point pressure conversion against the map()/double code it
+/// replaced
+/// @details Every 12-bit ADC code goes to mbar, mmHg, kPa and inHg, once
+/// the old way (integer counts to mV, Arduino map() to mbar, double
+/// division to the other units) and once through units::PressureMap and
+/// the Q16 factors. The report gives the worst error of both against an
+/// exact double precision transfer function and their time per conversion.
+/// The timing is only meaningful in an optimised build
+/// (CMAKE_BUILD_TYPE=Release). The host has an FPU and a divider, the
+/// Cortex-M0+ has neither, so it understates the gap on the target.
+/// @param mv_min, mv_max, mbar_min, mbar_max Sensor transfer function
+/// @return 0 if every check passed, 1 otherwise
+int units_benchmark(int32_t mv_min, int32_t mv_max, int32_t mbar_min,
+                    int32_t mbar_max);
@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstdint>
+
+/// @brief Signed Q-format fixed point number in 32 bits
+/// @details Factors are built from doubles in constexpr context only, so no
+/// floating point code ends up in the firmware. Scaling an integer is a
+/// single 32-bit multiply: the caller keeps |value * factor.raw()| below
+/// 2^31, which is what FracBits is chosen for.
+/// @tparam FracBits Number of fractional bits
+template <unsigned FracBits>
+class Fixed {
+    static_assert(FracBits > 0 && FracBits < 31, "FracBits out of range");
+
+public:
+    static constexpr int32_t ONE = INT32_C(1) << FracBits;
+
+    constexpr Fixed() = default;
+
+    static constexpr Fixed from_raw(int32_t raw) { return Fixed(raw); }
+
+    static constexpr Fixed from_int(int32_t value) {
+        return Fixed(value * ONE);
+    }
+
+    /// @brief Rounded conversion, meant for compile time constants
+    static constexpr Fixed from_double(double value) {
+        return Fixed((int32_t)(value * ONE + (value < 0 ? -0.5 : 0.5)));
+    }
+
+    /// @brief Exact ratio num / den, meant for compile time constants
+    static constexpr Fixed from_ratio(int64_t num, int64_t den) {
+        return Fixed((int32_t)((num * ONE * 2 + (num < 0 ? -den : den)) /
+                               (2 * den)));
+    }
+
+    constexpr int32_t raw() const { return _raw; }
+
+    /// @brief Integer part, rounded towards minus infinity
+    constexpr int32_t floor() const { return _raw >> FracBits; }
+
+    /// @brief Nearest integer
+    constexpr int32_t round() const { return (_raw + ONE / 2) >> FracBits; }
+
+    /// @brief Value scaled by 10^decimals and rounded, eg. tenths of kPa
+    constexpr int32_t decimal(unsigned decimals) const {
+        int32_t scale = 1;
+        while (decimals--) scale *= 10;
+        return Fixed(_raw * scale).round();
+    }
+
+    constexpr Fixed operator+(Fixed other) const {
+        return Fixed(_raw + other._raw);
+    }
+    constexpr Fixed operator-(Fixed other) const {
+        return Fixed(_raw - other._raw);
+    }
+
+    /// @brief Scale an integer by this factor
+    constexpr Fixed operator*(int32_t value) const {
+        return Fixed(_raw * value);
+    }
+
+    /// @brief Product of two fixed point numbers
+    /// @details Needs a 32x32->64 multiply, prefer scaling an integer when
+    /// the operand has no useful fraction.
+    constexpr Fixed operator*(Fixed other) const {
+        return Fixed((int32_t)(((int64_t)_raw * other._raw) >> FracBits));
+    }
+
+    /// @brief Product with a factor of another precision, rounded to this
+    /// one
+    /// @details A factor well below 1 keeps its relative precision with
+    /// more fraction bits, eg. Q30, at the same 32x32->64 multiply.
+    template <unsigned FactorBits>
+    constexpr Fixed scaled(Fixed<FactorBits> factor) const {
+        return Fixed((int32_t)(((int64_t)_raw * factor.raw() +
+                                (INT64_C(1) << (FactorBits - 1))) >>
+                               FactorBits));
+    }
+
+    constexpr bool operator<(Fixed other) const { return _raw < other._raw; }
+    constexpr bool operator==(Fixed other) const {
+        return _raw == other._raw;
+    }
+
+private:
+    constexpr explicit Fixed(int32_t raw) : _raw(raw) {}
+
+    int32_t _raw = 0;
+};
+
+template <unsigned FracBits>
+constexpr Fixed<FracBits> operator*(int32_t value, Fixed<FracBits> factor) {
+    return factor * value;
+}
+
+/// @brief Linear range mapping with a precomputed slope
+/// @details Same result as Arduino's map() without the division:
+/// out = (x - in_min) * slope + out_min.
+template <unsigned FracBits>
+class LinearMap {
+public:
+    constexpr LinearMap(int32_t in_min, int32_t in_max, int32_t out_min,
+                        int32_t out_max)
+        : _in_min(in_min),
+          _out_min(Fixed<FracBits>::from_int(out_min)),
+          _slope(Fixed<FracBits>::from_ratio(out_max - out_min,
+                                             in_max - in_min)) {}
+
+    constexpr LinearMap(int32_t in_min, Fixed<FracBits> out_min,
+                        Fixed<FracBits> slope)
+        : _in_min(in_min), _out_min(out_min), _slope(slope) {}
+
+    constexpr Fixed<FracBits> operator()(int32_t x) const {
+        return _slope * (x - _in_min) + _out_min;
+    }
+
+    constexpr int32_t in_min() const { return _in_min; }
+    constexpr Fixed<FracBits> out_min() const { return _out_min; }
+    constexpr Fixed<FracBits> slope() const { return _slope; }
+
+private:
+    int32_t _in_min;
+    Fixed<FracBits> _out_min;
+    Fixed<FracBits> _slope;
+};
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+
+#include "FixedPoint.h"
+
+/// @brief Pressure unit conversion without division or floating point
+namespace units {
+
+/// @brief Fraction bits of every pressure value, mbar * 2^16 fits 32 bits
+constexpr unsigned PRESSURE_FRAC_BITS = 16;
+
+typedef Fixed<PRESSURE_FRAC_BITS> Pressure;
+typedef LinearMap<PRESSURE_FRAC_BITS> PressureMap;
+
+/// @brief Unit factors, all below 1: Q30 keeps them within 5e-10, where
+/// Q16 would be off by up to 2.6e-4 relative, 0.01 inHg at full scale
+typedef Fixed<30> Factor;
+
+constexpr Factor MBAR_TO_MMHG = Factor::from_double(1.0 / 1.33322368);
+constexpr Factor MBAR_TO_KPA = Factor::from_ratio(1, 10);
+constexpr Factor MBAR_TO_INHG = Factor::from_double(1.0 / 33.8638866);
+
+/// @brief Linear sensor transfer function from mV to mbar
+constexpr PressureMap sensor_mv_to_mbar(int32_t mv_min, int32_t mv_max,
+                                        int32_t mbar_min, int32_t mbar_max) {
+    return PressureMap(mv_min, mv_max, mbar_min, mbar_max);
+}
+
+/// @brief The same transfer function applied directly to raw ADC counts
+/// @param vref_mv ADC reference voltage
+/// @param full_scale Number of ADC codes, eg. 4096 for 12 bits
+constexpr PressureMap sensor_counts_to_mbar(int32_t vref_mv,
+                                            int32_t full_scale,
+                                            int32_t mv_min, int32_t mv_max,
+                                            int32_t mbar_min,
+                                            int32_t mbar_max) {
+    // mbar = counts * vref / fs * k + (mbar_min - mv_min * k)
+    // with k = (mbar_max - mbar_min) / (mv_max - mv_min)
+    return PressureMap(
+        0,
+        Pressure::from_ratio((int64_t)mbar_min * (mv_max - mv_min) -
+                                 (int64_t)mv_min * (mbar_max - mbar_min),
+                             mv_max - mv_min),
+        Pressure::from_ratio((int64_t)vref_mv * (mbar_max - mbar_min),
+                             (int64_t)full_scale * (mv_max - mv_min)));
+}
+
+constexpr Pressure to_mmhg(Pressure mbar) { return mbar.scaled(MBAR_TO_MMHG); }
+constexpr Pressure to_kpa(Pressure mbar) { return mbar.scaled(MBAR_TO_KPA); }
+constexpr Pressure to_inhg(Pressure mbar) { return mbar.scaled(MBAR_TO_INHG); }
+
+/// @brief Integer mbar to mmHg, for values already rounded to mbar
+constexpr int32_t mbar_to_mmhg(int32_t mbar) {
+    return to_mmhg(Pressure::from_int(mbar)).floor();
+}
+
+}  // namespace units
@@ -0,0 +1,200 @@
+#include "vacuum-meter-bt-host.h"
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <string>
+#include <vector>
+
+#include "EngineVacuum.h"
+#include "FftBenchmark.h"
+#include "SkewBenchmark.h"
+#include "AdcRingBenchmark.h"
+#include "SpscBenchmark.h"
+#include "UnitsBenchmark.h"
+#include "LcdTxBenchmark.h"
+#include "Hd44780Model.h"
+#include "HalHost.h"
+#include "vacuum-meter-bt.h"
+
+namespace {
+
+constexpr uint8_t LCD_ADDRESS = 0x27;
+// menu navigation starts once the splash screen is gone
+constexpr uint64_t INPUT_START_US = 3000000U;
+// one scripted pin change every 10 ms, a few 4 ms input polls each
+constexpr uint64_t INPUT_STEP_US = 10000U;
+constexpr uint64_t CLICK_US = 100000U;
+
+struct PinStep {
+    uint64_t t_us;
+    uint8_t pin;
+    bool level;
+};
+
+struct FrameSummary {
+    uint32_t frames;
+    uint32_t maxBytes;
+    uint64_t maxBusNs;
+};
+
+Hd44780Model s_lcd(16, 2);
+EngineVacuum *s_engine = nullptr;
+std::vector<PinStep> s_input;
+size_t s_next_step = 0;
+bool s_print_frames = false;
+std::string s_screen;
+FrameSummary s_summary = {};
+Hd44780Model::FrameStats s_setup = {};
+
+uint64_t input_event(void *, uint64_t) {
+    const PinStep &step = s_input[s_next_step++];
+    hal::host::gpio_set(step.pin, step.level);
+    return s_next_step < s_input.size() ? s_input[s_next_step].t_us : 0;
+}
+
+// One detent clockwise: four quadrature states, pin A leading
+void add_detent(uint64_t &t_us) {
+    static const bool c_STATES[4][2] = {{1, 0}, {0, 0}, {0, 1}, {1, 1}};
+    for (const auto &state : c_STATES) {
+        s_input.push_back({t_us, ENCODER_A, state[0]});
+        s_input.push_back({t_us, ENCODER_B, state[1]});
+        t_us += INPUT_STEP_US;
+    }
+}
+
+void select_mode(int mode) {
+    uint64_t t_us = INPUT_START_US;
+    for (int i = 1; i < mode; i++) {
+        add_detent(t_us);
+    }
+    s_input.push_back({t_us, BUTTON, false});
+    s_input.push_back({t_us + CLICK_US, BUTTON, true});
+    hal::host::schedule(s_input.front().t_us, input_event, nullptr);
+}
+
+}  // namespace
+
+bool host_init(int argc, char **argv) {
+    int opt;
+    int mode = 0;
+    EngineVacuum::Config engine;
+    bool running = false;
+    engine.cylinders = ENGINE_CYLINDERS;
+    engine.sensor_mv_min = VACCUM_AMIN;
+    engine.sensor_mv_max = VACCUM_AMAX;
+    engine.sensor_mbar_min = VACCUM_VMIN;
+    engine.sensor_mbar_max = VACCUM_VMAX;
+    while ((opt = getopt(argc, argv, "t:m:fs:r:c:i:d:n:b")) != -1) {
+        switch (opt) {
+            case 't':
+                hal::host::set_end_time(strtoull(optarg, nullptr, 10) *
+                                        1000000U);
+                break;
+            case 'm':
+                mode = atoi(optarg);
+                break;
+            case 'f':
+                s_print_frames = true;
+                break;
+            case 's':
+                hal::host::set_speed(atoi(optarg));
+                break;
+            case 'r': {
+                char *end;
+                running = true;
+                engine.rpm = strtod(optarg, &end);
+                if (*end == ',') engine.rpm_end = strtod(end + 1, &end);
+                if (*end == ',') engine.ramp_s = strtod(end + 1, &end);
+                break;
+            }
+            case 'c':
+                engine.cylinders = atoi(optarg);
+                break;
+            case 'i':
+                engine.imbalance_mbar[1] = strtod(optarg, nullptr);
+                break;
+            case 'd':
+                engine.pulse_scale[1] = strtod(optarg, nullptr);
+                break;
+            case 'n':
+                engine.noise_mbar = strtod(optarg, nullptr);
+                break;
+            case 'b':
+                exit(fft_benchmark() | skew_benchmark() | adc_ring_benchmark() |
+                     spsc_benchmark() |
+                     units_benchmark(VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN,
+                                     VACCUM_VMAX) |
+                     lcd_tx_benchmark());
+            default:
+                fprintf(stderr,
+                        "usage: %s [-t seconds] [-m mode] [-f] [-s factor] "
+                        "[-r rpm[,rpm_end,ramp_s]] [-c cylinders] "
+                        "[-i mbar] [-d factor] [-n mbar] [-b]\n",
+                        argv[0]);
+                return false;
+        }
+    }
+    if (mode < 0 || mode > MENU_OPTIONS) {
+        fprintf(stderr, "mode must be 1-%d\n", MENU_OPTIONS);
+        return false;
+    }
+
+    // idle levels of the pulled-up encoder and button contacts
+    hal::host::gpio_set(ENCODER_A, true);
+    hal::host::gpio_set(ENCODER_B, true);
+    hal::host::gpio_set(BUTTON, true);
+    hal::host::attach_i2c(LCD_ADDRESS, &s_lcd);
+    if (running) {
+        s_engine = new EngineVacuum(engine);
+        hal::host::set_analog_source(EngineVacuum::analog_source, s_engine);
+    }
+    if (mode) select_mode(mode);
+    return true;
+}
+
+void host_start() {
+    const Hd44780Model::FrameStats setup = s_lcd.takeFrame();
+    printf("LCD setup: %u B, %u transactions, %.1f ms bus\n", setup.i2cBytes,
+           setup.i2cTransactions, setup.busNs / 1e6);
+    s_setup = setup;
+}
+
+void host_frame() {
+    const Hd44780Model::FrameStats frame = s_lcd.takeFrame();
+    s_summary.frames++;
+    if (frame.i2cBytes > s_summary.maxBytes) {
+        s_summary.maxBytes = frame.i2cBytes;
+    }
+    if (frame.busNs > s_summary.maxBusNs) s_summary.maxBusNs = frame.busNs;
+
+    const std::string screen = s_lcd.text(0) + "|" + s_lcd.text(1);
+    if (!s_print_frames || screen == s_screen) return;
+    s_screen = screen;
+    printf("%9.3f |%s| %4u B %3u tx %6.0f us bus %6.0f us wall %u busy\n",
+           hal::time_us() / 1e6, screen.c_str(), frame.i2cBytes,
+           frame.i2cTransactions, frame.busNs / 1e3, frame.wallNs / 1e3,
+           frame.busyViolations);
+}
+
+void host_exit() {
+    hal::host::set_analog_source(nullptr, nullptr);
+    delete s_engine;
+    s_engine = nullptr;
+    s_lcd.takeFrame();
+    Hd44780Model::FrameStats total = s_lcd.totals();
+    total.i2cBytes -= s_setup.i2cBytes;
+    total.i2cTransactions -= s_setup.i2cTransactions;
+    total.busNs -= s_setup.busNs;
+    const uint32_t frames = s_summary.frames ? s_summary.frames : 1;
+    printf("simulated %.1f s, %u LCD frames\n", hal::time_us() / 1e6,
+           s_summary.frames);
+    printf("per frame: %.1f B (max %u), %.1f transactions, %.0f us bus "
+           "(max %.0f us)\n",
+           (double)total.i2cBytes / frames, s_summary.maxBytes,
+           (double)total.i2cTransactions / frames,
+           total.busNs / 1e3 / frames, s_summary.maxBusNs / 1e3);
+    printf("LCD: %u instructions, %u data writes, %u busy violations\n",
+           total.instructions, total.dataWrites, total.busyViolations);
+}
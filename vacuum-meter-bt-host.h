@@ -0,0 +1,33 @@
+#pragma once
+
+// Host build only: simulated peripherals and the command line of a run
+
+/// @brief Parse the command line and attach the simulated peripherals
+/// @details Called before setup(). Options:
+/// -t SECONDS  simulated run time, forever by default
+/// -m MODE     enter menu function MODE (1-6) through the encoder
+/// -f          print every frame which changed the screen
+/// -s FACTOR   run FACTOR times faster than real time, 0 is unthrottled
+/// -r RPM[,END,SECONDS]
+///             feed the ADC from a running engine, optionally ramping its
+///             speed to END over SECONDS; without it the inputs sit at
+///             mid-scale
+/// -c N        number of cylinders, ENGINE_CYLINDERS by default; ADC0 to
+///             ADC3 watch cylinders 1 to 4
+/// -i MBAR     base pressure offset of ADC1's cylinder (carb imbalance)
+/// -d FACTOR   pulse depth of cylinder 2 relative to cylinder 1
+/// -n MBAR     rms pressure noise
+/// -b          run the FFT, channel skew, ADC ring, SPSC queue, pressure
+///             units and LCD transmit queue benchmarks, exit with the
+///             result
+/// @return False on a usage error
+bool host_init(int argc, char **argv);
+
+/// @brief Called after setup(), drops the setup traffic from the statistics
+void host_start();
+
+/// @brief Called after every LCD refresh
+void host_frame();
+
+/// @brief Print the statistics of the run
+void host_exit();
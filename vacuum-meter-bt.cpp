@@ -5,39 +5,95 @@
  */
 
 #include <stdio.h>
+#include <string.h>
+#include <atomic>
 #include <string>
 #include "vacuum-meter-bt.h"
-#include "pico/stdlib.h"
-#include "hardware/gpio.h"
-#include "hardware/adc.h"
+#include "Hal.h"
+#include "AdcDma.h"
 #include "custom_chars.h"
 #include "LiquidCrystal_I2C.h"
-#include "EncoderButton.h"
+#include "StaticEncoderButton.h"
+#include "DebounceBank.h"
+#ifdef VACUUM_HOST
+#include "vacuum-meter-bt-host.h"
+#endif
 #ifdef WIFI
 #include "pico/cyw43_arch.h"
 #endif
+#ifdef DUAL_CORE
+#include "hardware/sync.h"
+#include "pico/multicore.h"
+#endif
 
 LiquidCrystal_I2C lcd(0x27, 16, 2);
-EncoderButton encoder(6, 7, 8);
-
-repeating_timer_t timer;
+LcdTxQueue g_lcd_tx;
+DebounceBank g_buttons;
+typedef StaticEncoderButton<ENCODER_A, ENCODER_B, BUTTON,
+                            BankButton<g_buttons>>
+    InputEncoder;
+InputEncoder encoder;
+AdcDma<ADC_BLOCK_SAMPLES, ADC_RING_BLOCKS> g_adc;
+
+hal::RepeatingTimer timer;
 uint8_t g_menu_option = 1;
-uint16_t g_delta = 0;
+int g_offset[ADC_CHANNELS] = {};  // mbar, makes every channel read like 1
 uint16_t g_pressure_atmo = 0;
 bool g_setup_done = false;
 volatile uint8_t g_menu_state = 0;
 volatile bool g_enter_function = true;
-volatile uint16_t g_vacuum_1 = 0;
-volatile uint16_t g_vacuum_2 = 0;
+SpscQueue<VacuumSample, FIFO_LENGTH> g_samples;
+SpscQueue<CycleSample, CYCLE_FIFO_LENGTH> g_cycles;
+SpscQueue<NoiseSample, 2> g_noise;
+
+/// @brief Signal processing state of one input
+struct Channel {
+#ifdef OVERSAMPLING
+    CicDecimator<ADC_CIC_ORDER, ADC_DECIMATION, SAMPLE_FRAC_BITS> cic;
+#endif
+    NoiseMeter<NOISE_WINDOW> noise{12U + SAMPLE_FRAC_BITS};
+    SpikeFilter spikes;
+    CycleAverager cycle{CYCLE_MIN_PERIOD, CYCLE_MAX_PERIOD, CYCLE_HYSTERESIS};
+    VacuumDamping damping;
+};
+Channel g_channels[ADC_CHANNELS];
+ChannelAligner g_aligner;
+RpmEstimator<> g_rpm_estimator(ADC_CHANNEL_RATE, RPM_MIN, RPM_MAX);
+uint16_t g_vacuum[ADC_CHANNELS] = {};
+volatile uint8_t g_reference = 0;  // channel the Synchro screen compares to
+uint16_t g_rpm = 0;
+CycleSample g_cycle = {};
+
+// The spectrum window belongs to the acquisition while capturing and to
+// the main loop once ready
+enum SpectrumState : uint8_t {
+    SPECTRUM_OFF,
+    SPECTRUM_CAPTURE,
+    SPECTRUM_READY
+};
+std::atomic<uint8_t> g_spectrum_state{SPECTRUM_OFF};
+// a channel, or ADC_CHANNELS for the mean of all of them
+volatile uint8_t g_spectrum_source = ADC_CHANNELS;
+int16_t g_spectrum_re[SPECTRUM_POINTS];
+int16_t g_spectrum_im[SPECTRUM_POINTS];
+SpectrumReport g_spectrum = {};
 volatile bool g_update_lcd = false;
 
 int setup() {
-    stdio_init_all();
-
-    adc_init();
-    // Make sure GPIO is high-impedance, no pullups etc
-    adc_gpio_init(26);
-    adc_gpio_init(27);
+    hal::init();
+
+    hal::adc_setup();
+    // GPIOs are set to high-impedance by the acquisition
+#ifdef DUAL_CORE
+    // DMA IRQ gets enabled on the core which calls begin()
+    multicore_launch_core1(core1_entry);
+    if (!multicore_fifo_pop_blocking()) {
+#else
+    if (!g_adc.begin(ADC_INPUT_MASK, ADC_SAMPLE_RATE, adc_process_blocks)) {
+#endif
+        printf("Failed to init ADC\n");
+        return 1;
+    }
 #ifdef WIFI
     if (cyw43_arch_init()) {
         printf("Wi-Fi init failed");
@@ -45,40 +101,76 @@ int setup() {
     }
 #endif
 
-    if (!add_repeating_timer_ms(-4, timer_callback, NULL, &timer)) {
+    if (!hal::add_repeating_timer_ms(-4, timer_callback, nullptr, &timer)) {
         printf("Failed to add timer\n");
         return 1;
     }
     
     lcd.init();
-    lcd.createChar(0, chStartEmpty);
-    lcd.createChar(1, caseEmpty);
-    lcd.createChar(2, chCase1);
-    lcd.createChar(3, chCase2);
-    lcd.createChar(4, chCase3);
-    lcd.createChar(5, chCase4);
-    lcd.createChar(6, chCase5);
-    lcd.createChar(7, chEndEmpty);
+    lcd.init_bargraph(LCD_BARGRAPH_FRAMED);
+    if (lcd.setBusyPolling(true)) {
+        printf("LCD busy: clear %lu us, home %lu us, entry mode %lu us, "
+               "+-%lu us per flag poll\n",
+               (unsigned long)lcd.measureCommandUs(LCD_CLEARDISPLAY),
+               (unsigned long)lcd.measureCommandUs(LCD_RETURNHOME),
+               (unsigned long)lcd.measureCommandUs(LCD_ENTRYMODESET |
+                                                   LCD_ENTRYLEFT),
+               (unsigned long)lcd.pollUs());
+    } else {
+        printf("LCD busy flag not readable, using timed delays\n");
+    }
 
     lcd.backlight();
     lcd.clear();
     lcd.print("VacuumMeter");
     lcd.setCursor(0, 1);
     lcd.print("      by wgrs33");
-    sleep_ms(2000);
-    lcd.clear();
+    hal::sleep_ms(2000);
+    // From now on only changed cells are sent, once per refresh, by DMA
+    if (!lcd.setTxQueue(&g_lcd_tx)) {
+        printf("LCD DMA unavailable, using blocking writes\n");
+    }
+    lcd.setBuffered(true);
 
-    encoder.setEncoderHandler([](EncoderButton &e) {
+    // The timer IRQ only queues input events, loop() runs the handlers
+    encoder.useEventQueue();
+    encoder.setEncoderHandler([](InputEncoder &e, void *) {
         if (!g_menu_state) {
             auto val = g_menu_option + e.increment();
-            g_menu_option = constrain(val, 1, 4);
+            g_menu_option = constrain(val, 1, MENU_OPTIONS);
+        } else if (g_menu_state == MENU_SYNCHRO) {
+            const int channel =
+                g_reference + e.increment() % (int)ADC_CHANNELS;
+            g_reference = (channel + ADC_CHANNELS) % ADC_CHANNELS;
+        } else if (g_menu_state == MENU_SPECTRUM) {
+            constexpr int c_SOURCES = ADC_CHANNELS + 1;
+            const int source = g_spectrum_source + e.increment() % c_SOURCES;
+            g_spectrum_source = (source + c_SOURCES) % c_SOURCES;
+        } else if (g_menu_state == MENU_DAMPING) {
+            // takes effect with the next sample, acquisition runs on
+            auto mode = g_channels[0].damping.mode() + e.increment();
+            mode = constrain(mode, 0, VacuumDamping::MODES - 1);
+            for (Channel &channel : g_channels) channel.damping.setMode(mode);
         }
     });
-    encoder.setLongClickHandler([](EncoderButton &e) { g_menu_state = 0; });
-    encoder.setClickHandler([](EncoderButton &e) {
+    encoder.setLongClickHandler(
+        [](InputEncoder &e, void *) { g_menu_state = 0; });
+    encoder.setClickHandler([](InputEncoder &e, void *) {
+        if (g_menu_state == MENU_DAMPING) {
+            const bool enable = !g_channels[0].spikes.enabled();
+            for (Channel &channel : g_channels) {
+                channel.spikes.setEnabled(enable);
+            }
+            return;
+        }
         g_enter_function = true;
         g_menu_state = g_menu_option;
     });
+#ifdef DUAL_CORE
+    multicore_fifo_push_blocking(1);
+#else
+    g_adc.start();
+#endif
     g_setup_done = true;
     return 0;
 }
@@ -87,6 +179,9 @@ void loop() {
 #ifdef WIFI
     static bool out = true;
 #endif
+    encoder.dispatch();
+    read_samples();
+    process_spectrum();
     if (g_update_lcd) {
         g_update_lcd = false;
         updateLcd();
@@ -97,15 +192,27 @@ void loop() {
     }
 }
 
-int main() {
+int main(int argc, char **argv) {
+#ifdef VACUUM_HOST
+    if (!host_init(argc, argv)) {
+        return 2;
+    }
+#endif
     if (setup() != 0) {
         return 1;
     }
-    while (1) {
+#ifdef VACUUM_HOST
+    host_start();
+#endif
+    while (hal::running()) {
         loop();
+        hal::idle();
     }
 
-    cancel_repeating_timer(&timer);
+    hal::cancel_repeating_timer(&timer);
+#ifdef VACUUM_HOST
+    host_exit();
+#endif
     return 0;
 }
 
@@ -129,145 +236,188 @@ void show_menu() {
             lcd.setCursor(0, 1);
             lcd.print("<  Calibrate   >");
             break;
+        case 5:
+            lcd.setCursor(0, 1);
+            lcd.print("<   Spectrum   >");
+            break;
+        case 6:
+            lcd.setCursor(0, 1);
+            lcd.print("<   Damping    >");
+            break;
     }
 }
 
 void synchronization() {
-    static int pressure_V1;
-    static int pressure_V2;
-
-    pressure_V1 =
-        map(g_vacuum_1, VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
-    pressure_V2 =
-        map(g_vacuum_2, VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
-    pressure_V2 = pressure_V2 + g_delta;
+    static int pressure[ADC_CHANNELS];
+
+    // a cycle is stale once a whole maximum period has passed without one
+    const uint32_t age_us = (uint32_t)hal::time_us() - g_cycle.timestamp_us;
+    const bool cycle = g_cycle.period_us &&
+        age_us < 2 * CYCLE_MAX_PERIOD * (1000000U / ADC_CHANNEL_RATE);
+    for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+        pressure[ch] =
+            c_MV_TO_MBAR(cycle ? g_cycle.mean[ch] : g_vacuum[ch]).floor() +
+            g_offset[ch];
+    }
+    const unsigned ref = g_reference % ADC_CHANNELS;
+
+    if (ADC_CHANNELS == 2) {
+        lcd.setCursor(0, 0);
+        lcd.print("    ");
+        lcd.setCursor(0, 0);
+        lcd.print(pressure[0]);
+        // engine speed between the readings, the unit while it is unknown
+        lcd.setCursor(5, 0);
+        if (g_rpm) {
+            align_right(g_rpm, 5);
+        } else {
+            lcd.print(" mbar");
+        }
+        lcd.setCursor(12, 0);
+        align_right(pressure[1], 4);
+        // the bar shows the other channel against the starred one
+        lcd.setCursor(4, 0);
+        lcd.print(ref == 0 ? '*' : ' ');
+        lcd.setCursor(11, 0);
+        lcd.print(ref == 1 ? '*' : ' ');
+
+        set_bar(constrain(((pressure[1 - ref] - pressure[ref] + BAR_MAX) / 2),
+                          BAR_MIN, BAR_MAX));
+        return;
+    }
 
     lcd.setCursor(0, 0);
-    lcd.print("    ");
-    lcd.setCursor(0, 0);
-    lcd.print(pressure_V1);
-    lcd.setCursor(12, 0);
-    align_right(pressure_V2, 4);
-
-    set_bar(constrain(((pressure_V2 - pressure_V1 + BAR_MAX) / 2), BAR_MIN,
-                      BAR_MAX));
+    lcd.print('R');
+    lcd.print((int)ref + 1);
+    lcd.setCursor(3, 0);
+    align_right(pressure[ref], 4);
+    lcd.setCursor(7, 0);
+    if (g_rpm) {
+        align_right(g_rpm, 5);
+        lcd.print(" rpm");
+    } else {
+        lcd.print(" mbar    ");
+    }
+    for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+        lcd.setCursor(4 * ch, 1);
+        if (ch == ref) {
+            lcd.print(" ref");
+        } else {
+            align_right_signed(constrain(pressure[ch] - pressure[ref], -999,
+                                         999),
+                               4);
+        }
+    }
 }
 
 void pressure_diff() {
     static int pressure_V1;
 
-    pressure_V1 =
-        map(g_vacuum_1, VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX) -
-        g_pressure_atmo;
+    pressure_V1 = c_MV_TO_MBAR(g_vacuum[0]).floor() - g_pressure_atmo;
 
     lcd.setCursor(7, 0);
     lcd.print("    ");
     lcd.setCursor(7, 0);
     lcd.print(pressure_V1);
 
-    set_bar(
-        constrain(map(pressure_V1, VACCUM_DMIN, VACCUM_DMAX, BAR_MAX, BAR_MIN),
-                  BAR_MIN, BAR_MAX));
+    set_bar(constrain(c_DIFF_TO_BAR(pressure_V1).floor(), BAR_MIN, BAR_MAX));
 }
 
 void pressure_absolute() {
     static int pressure_V1;
 
-    pressure_V1 =
-        map(g_vacuum_1, VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
+    pressure_V1 = c_MV_TO_MBAR(g_vacuum[0]).floor();
 
     lcd.setCursor(7, 0);
     lcd.print("    ");
     lcd.setCursor(7, 0);
     lcd.print(pressure_V1);
     lcd.setCursor(0, 1);
-    pressure_V1 = (int)floor(pressure_V1 / c_MMHG);
+    pressure_V1 = units::mbar_to_mmhg(pressure_V1);
     lcd.setCursor(7, 1);
     lcd.print("     ");
     lcd.setCursor(7, 1);
     lcd.print(pressure_V1);
 }
 
-void set_bar(int value) {
-    static bool start = false;
-    static bool end = false;
+void spectrum() {
+    const uint8_t source = g_spectrum_source;
 
-    if (value == BAR_MIN) {
-        if (start) {
-            lcd.createChar(0, chStartEmpty);
-            start = false;
-        }
+    lcd.setCursor(0, 0);
+    if (source < ADC_CHANNELS) {
+        lcd.print((int)source + 1);
     } else {
-        if (!start) {
-            lcd.createChar(0, chStartFull);
-            start = true;
-        }
+        lcd.print('+');
     }
-
-    if (value == BAR_MAX) {
-        if (!end) {
-            lcd.createChar(7, chEndFull);
-            end = true;
-        }
+    lcd.setCursor(2, 0);
+    if (g_spectrum.fundamental_q8) {
+        const uint32_t tenths =
+            (uint32_t)(((uint64_t)g_spectrum.fundamental_q8 * SPECTRUM_RATE *
+                        10U) /
+                       (SPECTRUM_POINTS * 256U));
+        align_right(tenths / 10, 3);
+        lcd.print('.');
+        lcd.print((int)(tenths % 10));
     } else {
-        if (end) {
-            lcd.createChar(7, chEndEmpty);
-            end = false;
-        }
+        lcd.print(" --.-");
     }
+    lcd.setCursor(13, 0);
+    align_right(constrain(g_spectrum.subharmonic_permille / 10, 0, 99), 2);
+
+    for (unsigned i = 0; i < SpectrumReport::HARMONICS; i++) {
+        const int mbar =
+            (c_COUNTS_TO_MBAR.slope() * g_spectrum.amplitude[i]).round();
+        lcd.setCursor(1 + 3 * i, 1);
+        align_right(constrain(mbar, 0, 999), 3);
+    }
+}
 
+void damping() {
+    lcd.setCursor(13, 0);
+    lcd.print(g_channels[0].spikes.enabled() ? "on " : "off");
+    const char *name = VacuumDamping::name(g_channels[0].damping.mode());
     lcd.setCursor(0, 1);
-    lcd.write((byte)0);
+    lcd.print(name);
+    for (size_t i = strlen(name); i < 16; i++) lcd.print(' ');
+}
 
-    for (byte i = 1; i < 15; ++i) {
-        if (value > 5) {
-            lcd.write((byte)6);
-        } else {
-            switch (value) {
-                case 0:
-                    lcd.write((byte)1);
-                    break;
-                case 1:
-                    lcd.write((byte)2);
-                    break;
-                case 2:
-                    lcd.write((byte)3);
-                    break;
-                case 3:
-                    lcd.write((byte)4);
-                    break;
-                case 4:
-                    lcd.write((byte)5);
-                    break;
-                case 5:
-                    lcd.write((byte)6);
-                    break;
-            }
-        }
-        value = constrain((value - 5), BAR_MIN, BAR_MAX);
-    }
-    lcd.write((byte)7);
+void set_bar(int value) {
+    lcd.setCursor(0, 1);
+    lcd.writeGlyph(value == BAR_MIN ? chStartEmpty : chStartFull);
+    lcd.draw_horizontal_graph(1, 1, 14, value);
+    lcd.setCursor(15, 1);
+    lcd.writeGlyph(value == BAR_MAX ? chEndFull : chEndEmpty);
 }
 
 void align_right(int value, int max_length) {
+    static constexpr int c_POW10[] = {1,         10,        100,     1000,
+                                      10000,     100000,    1000000, 10000000,
+                                      100000000, 1000000000};
     for (int i = (max_length - 1); i > 0; --i) {
-        if (value < pow(10, i)) lcd.print(" ");
+        if (value < c_POW10[i]) lcd.print(" ");
     }
     lcd.print(value);
 }
 
+void align_right_signed(int value, int max_length) {
+    const int magnitude = value < 0 ? -value : value;
+    int digits = 1;
+    for (int rest = magnitude; rest >= 10; rest /= 10) digits++;
+    for (int i = digits + 1; i < max_length; i++) lcd.print(" ");
+    lcd.print(value < 0 ? '-' : '+');
+    lcd.print(magnitude);
+}
+
 void updateLcd() {
     if (g_setup_done) {
         switch (g_menu_state) {
             case 0:
                 show_menu();
                 break;
-            case 1:
+            case MENU_SYNCHRO:
                 if (g_enter_function) {
                     g_enter_function = false;
                     lcd.clear();
-                    lcd.setCursor(6, 0);
-                    lcd.print("mbar");
                 }
                 synchronization();
                 break;
@@ -299,42 +449,274 @@ void updateLcd() {
                     g_menu_state = 0;
                 }
                 break;
+            case 5:
+                if (g_enter_function) {
+                    g_enter_function = false;
+                    lcd.clear();
+                    lcd.setCursor(7, 0);
+                    lcd.print("Hz sub  %");
+                    lcd.setCursor(0, 1);
+                    lcd.print("A");
+                }
+                spectrum();
+                break;
+            case 6:
+                if (g_enter_function) {
+                    g_enter_function = false;
+                    lcd.clear();
+                    lcd.print("Damping  Spk");
+                }
+                damping();
+                break;
         }
+        lcd.flush();
+#ifdef VACUUM_HOST
+        host_frame();
+#endif
     }
 }
 
 bool calibrate() {
-    static unsigned int v1 = 0, v2 = 0;
+    static unsigned int sums[ADC_CHANNELS] = {};
     static uint8_t cnt = 0;
-    v1 += g_vacuum_1;
-    v2 += g_vacuum_2;
+    static bool measured = false;
+    static NoiseSample noise;
+    if (cnt == 0) {
+        // drop windows from before the ports were opened
+        while (g_noise.pop(noise)) {
+        }
+        measured = false;
+        for (unsigned int &sum : sums) sum = 0;
+    }
+    while (g_noise.pop(noise)) measured = true;
+    for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) sums[ch] += g_vacuum[ch];
 
     if (++cnt >= 10) {
-        g_pressure_atmo =
-            map((v1 / 10), VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
-        g_delta = g_pressure_atmo - map((v2 / 10), VACCUM_AMIN, VACCUM_AMAX,
-                                        VACCUM_VMIN, VACCUM_VMAX);
+        g_pressure_atmo = c_MV_TO_MBAR(sums[0] / 10).floor();
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            g_offset[ch] =
+                g_pressure_atmo - c_MV_TO_MBAR(sums[ch] / 10).floor();
+            if (measured) print_noise(ch + 1, noise.noise[ch]);
+        }
         cnt = 0;
         return true;
     }
     return false;
 }
 
-bool timer_callback(repeating_timer_t *rt) {
+void print_noise(int channel, const NoiseReport &report) {
+    printf("channel %d noise %lu.%02lu LSB rms, ENOB %lu.%02lu bits\n",
+           channel, (unsigned long)(report.rms_q8 >> 8),
+           (unsigned long)((report.rms_q8 & 0xFFU) * 100U >> 8),
+           (unsigned long)(report.enob_q8 >> 8),
+           (unsigned long)((report.enob_q8 & 0xFFU) * 100U >> 8));
+}
+
+#ifdef DUAL_CORE
+void core1_entry() {
+    // The IRQ only wakes this loop, blocks are processed in thread context
+    const bool ok =
+        g_adc.begin(ADC_INPUT_MASK, ADC_SAMPLE_RATE, []() { __sev(); });
+    multicore_fifo_push_blocking(ok);
+    if (!ok) return;
+
+    multicore_fifo_pop_blocking();
+    g_adc.start();
+    while (true) {
+        adc_process_blocks();
+        __wfe();
+    }
+}
+#endif
+
+void adc_process_blocks() {
+    const AdcBlock *block;
+    while ((block = g_adc.acquire()) != nullptr) {
+        unsigned int sums[ADC_CHANNELS] = {};
+        const uint32_t timestamp_us = (uint32_t)block->timestamp_us;
+        // Round robin starts from ADC input 0 (GPIO26) in every block
+        for (size_t i = 0; i < block->count; i += ADC_CHANNELS) {
+            uint16_t frame[ADC_CHANNELS];
+            bool ready = true;
+            for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+                frame[ch] = block->samples[i + ch] & ADC_RESULT_MASK;
+#ifdef OVERSAMPLING
+                // The decimators run in step, one output per ADC_DECIMATION
+                ready &= g_channels[ch].cic.push(frame[ch]);
+                frame[ch] = g_channels[ch].cic.output();
+#endif
+            }
+            if (!ready) continue;
+
+            bool noise_done = true;
+            for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+                noise_done &= g_channels[ch].noise.push(frame[ch]);
+                frame[ch] = g_channels[ch].spikes.push(frame[ch]);
+            }
+            if (noise_done) {
+                NoiseSample noise;
+                for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+                    noise.noise[ch] = g_channels[ch].noise.report();
+                }
+                g_noise.push(noise);
+            }
+            g_aligner.push(frame, frame);
+            for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+                sums[ch] += frame[ch];
+                // The rest of the signal chain works in 12-bit counts
+                frame[ch] >>= SAMPLE_FRAC_BITS;
+            }
+            // channel 1 closes the cycle, the others are ready by then
+            for (unsigned ch = 1; ch < ADC_CHANNELS; ch++) {
+                g_channels[ch].cycle.push(frame[ch]);
+            }
+            if (g_channels[0].cycle.push(frame[0])) push_cycle(timestamp_us);
+            g_rpm_estimator.push(frame[0]);
+            capture_spectrum(frame);
+        }
+        g_adc.release();
+        VacuumSample sample;
+        sample.timestamp_us = timestamp_us;
+        sample.rpm = (uint16_t)g_rpm_estimator.rpm();
+        // Convert to mV once per block instead of once per sample
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            const unsigned int mv = (c_SUM_TO_MV * sums[ch]).floor();
+            sample.vacuum[ch] =
+                (uint16_t)constrain(mv, VACCUM_AMIN, VACCUM_AMAX);
+        }
+        g_samples.push(sample);
+    }
+}
+
+void capture_spectrum(const uint16_t *samples) {
+    static unsigned int index = 0, count = 0, sum = 0;
+    if (g_spectrum_state.load(std::memory_order_acquire) != SPECTRUM_CAPTURE) {
+        index = count = sum = 0;
+        return;
+    }
+    const uint8_t source = g_spectrum_source;
+    if (source < ADC_CHANNELS) {
+        sum += samples[source];
+    } else {
+        unsigned int all = 0;
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) all += samples[ch];
+        sum += all / ADC_CHANNELS;
+    }
+    if (++count < SPECTRUM_DECIMATION) return;
+    g_spectrum_re[index++] = (int16_t)(sum / SPECTRUM_DECIMATION);
+    count = sum = 0;
+    if (index == SPECTRUM_POINTS) {
+        index = 0;
+        g_spectrum_state.store(SPECTRUM_READY, std::memory_order_release);
+    }
+}
+
+void process_spectrum() {
+    static uint8_t source = 0;
+    const uint8_t state = g_spectrum_state.load(std::memory_order_acquire);
+    if (g_menu_state != MENU_SPECTRUM) {
+        if (state != SPECTRUM_OFF) {
+            g_spectrum_state.store(SPECTRUM_OFF, std::memory_order_release);
+            g_spectrum = {};
+        }
+        return;
+    }
+    if (state == SPECTRUM_CAPTURE) return;
+    // a window captured across a source change is dropped
+    if (state == SPECTRUM_READY && source == g_spectrum_source) {
+        // one runner pulls once per cycle, the sum of all of them at the
+        // firing frequency; in 1/256 bins, when known
+        const unsigned int orders =
+            source < ADC_CHANNELS ? 1U : ENGINE_CYLINDERS;
+        const uint32_t fundamental_q8 = (uint32_t)(
+            (uint64_t)g_rpm * orders * SPECTRUM_POINTS * 256U /
+            (120U * SPECTRUM_RATE));
+        g_spectrum = analyze_spectrum<SPECTRUM_POINTS>(
+            g_spectrum_re, g_spectrum_im, fundamental_q8, orders);
+    }
+    source = g_spectrum_source;
+    g_spectrum_state.store(SPECTRUM_CAPTURE, std::memory_order_release);
+}
+
+void push_cycle(uint32_t timestamp_us) {
+    for (const Channel &channel : g_channels) {
+        if (!channel.cycle.locked()) return;
+    }
+    auto mv = [](uint16_t counts) {
+        return (uint16_t)(c_COUNT_TO_MV * counts).floor();
+    };
+    CycleSample cycle;
+    cycle.timestamp_us = timestamp_us;
+    cycle.period_us =
+        g_channels[0].cycle.last().period * (1000000U / ADC_CHANNEL_RATE);
+    for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+        const CycleStats &stats = g_channels[ch].cycle.last();
+        cycle.mean[ch] = mv(stats.mean);
+        cycle.min[ch] = mv(stats.min);
+        cycle.max[ch] = mv(stats.max);
+    }
+    g_cycles.push(cycle);
+}
+
+void read_samples() {
+    static unsigned int sums[ADC_CHANNELS] = {}, count = 0;
+    static uint16_t damped[ADC_CHANNELS] = {};
+    VacuumSample sample;
+    while (g_samples.pop(sample)) {
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            sums[ch] += sample.vacuum[ch];
+            damped[ch] = g_channels[ch].damping.push(sample.vacuum[ch]);
+        }
+        ++count;
+        g_rpm = sample.rpm;
+    }
+    // Whole engine cycles completed since the previous refresh, merged:
+    // the Synchro screen shows their mean at the display rate, however
+    // fast the engine turns
+    static CycleSample cycles = {};
+    static uint32_t cycle_sums[ADC_CHANNELS] = {}, period_sum = 0;
+    static unsigned cycle_count = 0;
+    CycleSample cycle;
+    while (g_cycles.pop(cycle)) {
+        if (!cycle_count) cycles = cycle;
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            cycle_sums[ch] += cycle.mean[ch];
+            if (cycle.min[ch] < cycles.min[ch]) cycles.min[ch] = cycle.min[ch];
+            if (cycle.max[ch] > cycles.max[ch]) cycles.max[ch] = cycle.max[ch];
+        }
+        period_sum += cycle.period_us;
+        cycles.timestamp_us = cycle.timestamp_us;
+        ++cycle_count;
+    }
+    // Show the mean of every sample since the previous refresh, or where
+    // the damped needle stands
+    const bool refresh = g_update_lcd;
+    if (refresh && count) {
+        const bool damping =
+            g_channels[0].damping.mode() != VacuumDamping::OFF;
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            g_vacuum[ch] = damping ? damped[ch] : sums[ch] / count;
+            sums[ch] = 0;
+        }
+        count = 0;
+    }
+    if (refresh && cycle_count) {
+        for (unsigned ch = 0; ch < ADC_CHANNELS; ch++) {
+            cycles.mean[ch] = (uint16_t)(cycle_sums[ch] / cycle_count);
+            cycle_sums[ch] = 0;
+        }
+        cycles.period_us = period_sum / cycle_count;
+        period_sum = 0;
+        cycle_count = 0;
+        g_cycle = cycles;
+    }
+}
+
+bool timer_callback(void *context) {
     static int counter = 0;
-    unsigned int sum_a0 = 0, sum_a1 = 0;
+    // one snapshot of every button, then the encoder reads its own
+    g_buttons.update();
     encoder.update();
-    // encoder.update();
-    for (uint8_t i = 0; i < ADC_SAMPLES; ++i) {
-        // Select ADC input 0 (GPIO26)
-        adc_select_input(0);
-        sum_a0 += (adc_read() * 3300 / 4096);
-        // Select ADC input 0 (GPIO26)
-        adc_select_input(1);
-        sum_a1 += (adc_read() * 3300 / 4096);
-    }
-    g_vacuum_1 = constrain(sum_a0 / ADC_SAMPLES, VACCUM_AMIN, VACCUM_AMAX);
-    g_vacuum_2 = constrain(sum_a1 / ADC_SAMPLES, VACCUM_AMIN, VACCUM_AMAX);
 
     if (++counter >= 50) {  // 50 * 4 ms = 200 ms
         counter = 0;
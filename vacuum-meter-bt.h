@@ -1,12 +1,25 @@
 #pragma once
 
 #include <cstdint>
-#include <math.h>
-#include "pico/util/queue.h"
-
+#include "Hal.h"
+#include "PressureUnits.h"
+#include "SpscQueue.h"
+#include "CycleAverager.h"
+#include "DampingFilter.h"
+#include "CicDecimator.h"
+#include "NoiseMeter.h"
+#include "SkewAligner.h"
+#include "RpmEstimator.h"
+#include "SpectrumAnalysis.h"
+
+constexpr int ENCODER_A = 6;
+constexpr int ENCODER_B = 7;
 constexpr int BUTTON = 8;
-constexpr int VACCUM_1 = 1;//A1;
-constexpr int VACCUM_2 = 0;//A0;
+
+constexpr int MENU_OPTIONS = 6;
+constexpr int MENU_SYNCHRO = 1;
+constexpr int MENU_SPECTRUM = 5;
+constexpr int MENU_DAMPING = 6;
 
 constexpr int BAR_MIN = 0;
 constexpr int BAR_MAX = 70;
@@ -19,20 +32,122 @@ constexpr int VACCUM_DMIN = -800;
 constexpr int VACCUM_DMAX = 1500;
 constexpr int FIFO_LENGTH = 32;
 
-constexpr double c_MMHG = 1.33322;
-constexpr unsigned int ADC_SAMPLES = 10U;
+// Pressure channels on ADC0 (GPIO26) up, set by the VACUUM_CHANNELS option.
+// ADC3 is GPIO29, not on the header of the Pico W: it reads VSYS/3 and
+// doubles as the CYW43 SPI clock. Only the host build takes 4.
+#ifndef VACUUM_CHANNELS
+#define VACUUM_CHANNELS 2
+#endif
+constexpr unsigned int ADC_CHANNELS = VACUUM_CHANNELS;
+#ifdef VACUUM_HOST
+static_assert(ADC_CHANNELS >= 2 && ADC_CHANNELS <= 4, "2 to 4 channels");
+#else
+static_assert(ADC_CHANNELS >= 2 && ADC_CHANNELS <= 3,
+              "2 or 3 channels, a Pico W has no ADC3 input");
+#endif
+constexpr unsigned int ADC_INPUT_MASK = (1U << ADC_CHANNELS) - 1U;
+/// @brief Samples per second of each channel after decimation
+constexpr unsigned int ADC_CHANNEL_RATE = 5000U;
+#ifdef OVERSAMPLING
+// Close to the full 500 kS/s, each channel CIC decimated to 16 bits (12.4
+// fixed): 50:1 for 2 channels, 33:1 for 3, 25:1 for 4
+constexpr unsigned int ADC_DECIMATION =
+    500000U / (ADC_CHANNEL_RATE * ADC_CHANNELS);
+constexpr unsigned int ADC_CIC_ORDER = 3U;
+constexpr unsigned int SAMPLE_FRAC_BITS = 4U;
+constexpr unsigned int ADC_RING_BLOCKS = 4U;
+#else
+constexpr unsigned int ADC_DECIMATION = 1U;
+constexpr unsigned int SAMPLE_FRAC_BITS = 0U;
+constexpr unsigned int ADC_RING_BLOCKS = 8U;
+#endif
+/// @brief Conversions per second, all inputs
+constexpr unsigned int ADC_SAMPLE_RATE =
+    ADC_CHANNEL_RATE * ADC_CHANNELS * ADC_DECIMATION;
+constexpr unsigned int ADC_SAMPLES = 20U; // per channel in one block (4 ms)
+constexpr unsigned int ADC_BLOCK_SAMPLES =
+    ADC_CHANNELS * ADC_SAMPLES * ADC_DECIMATION;
+constexpr unsigned int ADC_BLOCK_RATE = ADC_CHANNEL_RATE / ADC_SAMPLES;
+/// @brief How much later each channel is converted than the one before, in
+/// 1/65536 of a channel sample: one conversion of the round robin
+constexpr uint32_t ADC_SKEW_Q16 = 65536U / (ADC_CHANNELS * ADC_DECIMATION);
+// Every channel goes one sample back, the later ones by their skew more, so
+// the frames are simultaneous
+typedef SkewAligner<4, ADC_CHANNELS, ADC_SKEW_Q16> ChannelAligner;
+
+constexpr unsigned int RPM_MIN = 300U;
+constexpr unsigned int RPM_MAX = 12000U;
+// Engine cycle (720 deg) in samples of one channel
+constexpr unsigned int CYCLE_MIN_PERIOD = ADC_CHANNEL_RATE * 120U / RPM_MAX;
+constexpr unsigned int CYCLE_MAX_PERIOD = ADC_CHANNEL_RATE * 120U / RPM_MIN;
+constexpr unsigned int CYCLE_HYSTERESIS = 16U; // counts, ~10 mbar
+constexpr unsigned int CYCLE_FIFO_LENGTH = 16U;
+// One carb, so one channel, per cylinder
+constexpr unsigned int ENGINE_CYLINDERS = ADC_CHANNELS;
+constexpr unsigned int NOISE_WINDOW = 4096U; // samples, 0.8 s
+
+// Spectrum window: 512 points at 500 samples/s, 1 s long, 0.98 Hz bins
+constexpr unsigned int SPECTRUM_POINTS = 512U;
+constexpr unsigned int SPECTRUM_DECIMATION = 10U;
+constexpr unsigned int SPECTRUM_RATE = ADC_CHANNEL_RATE / SPECTRUM_DECIMATION;
+
+typedef DampingFilter<ADC_BLOCK_RATE> VacuumDamping;
+
+/// @brief Averaged readings of one DMA block, in mV
+template <unsigned Channels>
+struct VacuumFrame {
+    uint32_t timestamp_us;
+    uint16_t rpm;  // engine speed from the channel 1 pulses, 0 if unknown
+    uint16_t vacuum[Channels];
+};
+typedef VacuumFrame<ADC_CHANNELS> VacuumSample;
+
+/// @brief One engine cycle of every channel, in mV
+/// @details Sent when channel 1 completes a cycle, with the most recent
+/// cycle of the others, which is a fraction of a cycle older.
+template <unsigned Channels>
+struct CycleFrame {
+    uint32_t timestamp_us;
+    uint32_t period_us;
+    uint16_t mean[Channels];
+    uint16_t min[Channels];
+    uint16_t max[Channels];
+};
+typedef CycleFrame<ADC_CHANNELS> CycleSample;
+
+/// @brief Noise floor of every channel over NOISE_WINDOW samples
+struct NoiseSample {
+    NoiseReport noise[ADC_CHANNELS];
+};
 
 #define constrain(amt,low,high) ((amt)<(low)?(low):((amt)>(high)?(high):(amt)))
 
-long map(long x, long in_min, long in_max, long out_min, long out_max)
-{
-  return (x - in_min) * (out_max - out_min) / (in_max - in_min) + out_min;
-}
+/// @brief Sum of ADC_SAMPLES decimated samples to mV, the only conversion
+constexpr units::Pressure c_SUM_TO_MV = units::Pressure::from_ratio(
+    3300, (4096 << SAMPLE_FRAC_BITS) * ADC_SAMPLES);
+/// @brief Raw counts to mV
+constexpr units::Pressure c_COUNT_TO_MV =
+    units::Pressure::from_ratio(3300, 4096);
+/// @brief Sensor output in mV to absolute pressure in mbar
+constexpr units::PressureMap c_MV_TO_MBAR = units::sensor_mv_to_mbar(
+    VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
+/// @brief Raw counts to absolute pressure in mbar
+constexpr units::PressureMap c_COUNTS_TO_MBAR = units::sensor_counts_to_mbar(
+    3300, 4096, VACCUM_AMIN, VACCUM_AMAX, VACCUM_VMIN, VACCUM_VMAX);
+/// @brief Differential pressure in mbar to bar graph value
+constexpr units::PressureMap c_DIFF_TO_BAR{VACCUM_DMIN, VACCUM_DMAX, BAR_MAX,
+                                          BAR_MIN};
 
 /// @brief Show user menu
 void show_menu();
 
 /// @brief Show synchronization status (2 strokes)
+/// @details Compares the cycle means of every channel while the engine
+/// cycle is tracked, the block averages otherwise, against the reference
+/// channel picked with the encoder. Two channels: both readings with the
+/// engine speed between them, the bar shows the other channel relative to
+/// the reference. More channels: reference number, its reading and the
+/// engine speed on row 0, every channel relative to it on row 1.
 void synchronization();
 
 /// @brief Show differential pressure
@@ -41,6 +156,20 @@ void pressure_diff();
 /// @brief Show absolute pressure with mbar and mmHg
 void pressure_absolute();
 
+/// @brief Show the harmonic content of the intake pulses
+/// @details Row 0: source (channel number or + for all), fundamental and
+/// sub-harmonic share, row 1: amplitude of harmonics 1-5 in mbar. The
+/// encoder selects the source. One channel pulls once per engine cycle,
+/// rpm / 120, which has no fractional orders; the sum of all channels
+/// pulls at the firing frequency, where the sub-harmonic share shows
+/// cylinders which do not pull alike.
+void spectrum();
+
+/// @brief Show the damping of the readings
+/// @details The encoder changes the damping, a click toggles the ignition
+/// spike rejection on the raw samples.
+void damping();
+
 /// @brief Set bar graph value
 /// @param value value in the range [0 - 70]
 void set_bar(int value);
@@ -50,16 +179,63 @@ void set_bar(int value);
 /// @param max max length
 void align_right(int value, int max);
 
+/// @brief Align a signed value to right, with its sign
+/// @param value Value to show
+/// @param max max length, sign included
+void align_right_signed(int value, int max);
+
 /// @brief Calibrate inputs
-/// @details Both inputs must not be connected to any source.
-/// Atmospheric pressure is stored.
-/// Delta is calculated between two inputs.
+/// @details No input may be connected to any source.
+/// Atmospheric pressure is stored, from channel 1.
+/// Every other channel gets the offset which makes it read the same.
+/// The noise floor and ENOB of every channel are printed.
 /// @return True if calibration has finished
 bool calibrate();
 
+/// @brief Print one channel's noise floor, in LSB of the decimated samples
+void print_noise(int channel, const NoiseReport &report);
+
+/// @brief Average every completed DMA block and queue it for the main loop
+/// @details Runs from the DMA IRQ, or from the core1 loop in dual-core mode.
+/// With OVERSAMPLING the raw counts are CIC decimated first, the rest works
+/// on the decimated samples. The later channels are interpolated onto the
+/// time base of channel 1 after the spike rejection.
+/// Every sample passes the spike rejection first, when enabled, and also
+/// goes through the cycle averaging; completed cycles are queued as well.
+void adc_process_blocks();
+
+/// @brief Decimate the samples into the spectrum window while capturing
+/// @param samples One simultaneous sample of every channel
+void capture_spectrum(const uint16_t *samples);
+
+/// @brief Analyse a complete spectrum window and start the next one
+/// @details Main loop side of the capture, also starts and stops it with
+/// the Spectrum screen.
+void process_spectrum();
+
+/// @brief Queue a cycle of channel 1 with the latest one of the others
+void push_cycle(uint32_t timestamp_us);
+
+#ifdef DUAL_CORE
+/// @brief Core1 entry, owns the acquisition and signal processing
+/// @details Reports ADC init status and waits for the start command through
+/// the multicore FIFO, then processes blocks as they complete.
+void core1_entry();
+#endif
+
+/// @brief Drain queued samples into the display window
+/// @details Without damping the window mean is shown, with damping the
+/// latest filtered value. The engine cycles completed since the previous
+/// refresh are merged into one for the Synchro screen, so it refreshes at
+/// the display rate at any engine speed.
+void read_samples();
+
 /// @brief Timer callback when timer hit OC
-/// @param rt Timer handle
+/// @details Debounces the buttons from one GPIO snapshot, then samples the
+/// encoder, whose events are queued for loop(), and paces the display
+/// refresh.
+/// @param context Unused
 /// @return 
-bool timer_callback(repeating_timer_t *rt);
+bool timer_callback(void *context);
 
 void updateLcd();
\ No newline at end of file